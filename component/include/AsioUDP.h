@@ -21,6 +21,7 @@ public:
     
     // UDP implementation
     uint8_t begin(uint16_t port) override;
+    uint8_t begin(const IPAddress& address, uint16_t port);
     uint8_t beginMulticast(const IPAddress& addr, uint16_t port) override;
     void stop() override;
     int beginPacket(const IPAddress& ip, uint16_t port) override;
@@ -44,6 +45,14 @@ public:
     bool startReceiving();
     bool stopReceiving();
     
+    // Restrict IPv6 sockets to IPv6 peers, by default they also serve IPv4 peers
+    void setV6Only(bool v6_only);
+    
+    // Direct access to the transmit buffer, between beginPacket() and endPacket()
+    // prepare() returns room for size bytes at the end of the packet, commit() appends them
+    uint8_t* prepare(size_t size);
+    void commit(size_t size);
+    
 protected:
     // Implementation of the Stream::millis() method
     unsigned long millis() const override;
@@ -54,11 +63,12 @@ private:
     asio::ip::udp::socket socket_;
     asio::ip::udp::endpoint remote_endpoint_;
     std::vector<uint8_t> rx_buffer_;  // Receive buffer
-    std::vector<uint8_t> tx_buffer_;  // Transmit buffer
+    std::vector<uint8_t> tx_buffer_;  // Transmit buffer, only grows and is reused across packets
     
     // Buffer management
     size_t rx_pos_ = 0;        // Current read position in rx_buffer_
     size_t rx_available_ = 0;  // Number of bytes available to read
+    size_t tx_length_ = 0;     // Number of bytes written in tx_buffer_
     
     // Destination for outgoing packets
     asio::ip::udp::endpoint tx_endpoint_;
@@ -70,6 +80,15 @@ private:
     // Flag to track if we're receiving
     bool receiving_ = false;
     
+    // IPV6_V6ONLY option of IPv6 sockets
+    bool v6_only_ = false;
+    
+    // Family of the open socket, so sending doesn't query it
+    bool v6_socket_ = false;
+    
+    // Open the socket for the family of the address
+    bool open(const IPAddress& address);
+    
     // Start an asynchronous receive
     void startReceive();
     
@@ -5,76 +5,101 @@
 #include <string>
 #include <array>
 
+// Address family, as in the ESP32 Arduino core
+enum IPType : uint8_t {
+    IPv4,
+    IPv6
+};
+
 class IPAddress {
 private:
-    std::array<uint8_t, 4> bytes;
+    // IPv4 addresses use the first 4 bytes, IPv6 addresses use all 16 bytes
+    std::array<uint8_t, 16> bytes;
+    IPType family;
 
 public:
     // Default constructor
     IPAddress();
-    
+
+    // Constructor of the unspecified address of a family (0.0.0.0 or ::)
+    explicit IPAddress(IPType type);
+
+    // Constructor from raw bytes of a family (4 or 16 bytes)
+    IPAddress(IPType type, const uint8_t* address);
+
     // Constructor from 4 octets
     IPAddress(uint8_t first_octet, uint8_t second_octet, uint8_t third_octet, uint8_t fourth_octet);
-    
+
     // Constructor from uint32_t
     IPAddress(uint32_t address);
-    
+
     // Constructor from string
     IPAddress(const char* address);
-    
+
     // Constructor from std::string
     IPAddress(const std::string& address);
-    
+
     // Constructor from raw byte array
     IPAddress(const uint8_t* address);
-    
+
     // Copy constructor
     IPAddress(const IPAddress& other) = default;
-    
+
     // Move constructor
     IPAddress(IPAddress&& other) = default;
-    
+
     // Assignment operators
     IPAddress& operator=(const IPAddress& other) = default;
     IPAddress& operator=(uint32_t address);
     IPAddress& operator=(const uint8_t* address);
-    
-    // Convert to uint32_t
+
+    // Convert to uint32_t (IPv4 only, 0 for IPv6)
     operator uint32_t() const;
-    
+
     // Check if address is set
     bool isSet() const;
-    
+
     // Boolean conversion
     operator bool() const;
-    
+
     // Access individual octets
     uint8_t operator[](int index) const;
     uint8_t& operator[](int index);
-    
+
     // Equality operators
     bool operator==(const IPAddress& addr) const;
     bool operator!=(const IPAddress& addr) const;
     bool operator==(uint32_t addr) const;
     bool operator!=(uint32_t addr) const;
-    
+
+    // Address family
+    IPType type() const { return family; }
+    bool isV6() const { return family == IPv6; }
+
+    // Count of address bytes, 4 or 16
+    uint8_t size() const { return family == IPv6 ? 16 : 4; }
+
     // Convert to string
     std::string toString() const;
-    
-    // Parse from string
+
+    // Parse from string (dotted IPv4 or IPv6 text form)
     bool fromString(const char* address);
     bool fromString(const std::string& address);
-    
+
     // Static validation method
     static bool isValid(const char* address);
     static bool isValid(const std::string& address);
-    
+
     // Clear the address
     void clear();
-    
+
     // Raw access to the address bytes
     uint8_t* raw_address() { return bytes.data(); }
     const uint8_t* raw_address() const { return bytes.data(); }
+
+private:
+    // Parse IPv6 text form
+    bool fromString6(const char* address);
 };
 
 // Standard pre-defined IP addresses
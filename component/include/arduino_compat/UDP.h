@@ -14,7 +14,7 @@ public:
     virtual uint8_t begin(uint16_t port) = 0;
     
     // Optional: Initialize multicast support
-    virtual uint8_t beginMulticast(const IPAddress& addr, uint16_t port) { return 0; }
+    virtual uint8_t beginMulticast(const IPAddress& /* addr */, uint16_t /* port */) { return 0; }
     
     // Close the socket
     virtual void stop() = 0;
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include "arduino_compat/String.h"
 #include "arduino_compat/IPAddress.h"
+#include "snmp_oid.h"
 
 #ifdef __has_include
 #if __has_include("SNMPcfg.h")
@@ -18,13 +24,14 @@
 
 /**
  * @def SNMP_VECTOR
- * @brief Defines storage for ArrayBER.
+ * @brief Defines storage for ArrayBER, a vector if 1, an inline array spilling
+ * to the heap if 0.
  */
 #define SNMP_VECTOR 1
 
 /**
  * @def SNMP_CAPACITY
- * @brief Defines capacity of SequenceBER.
+ * @brief Defines inline capacity of SequenceBER if SNMP_VECTOR is 0.
  */
 #define SNMP_CAPACITY 6
 #endif
@@ -34,9 +41,7 @@
 #include <Stream.h>
 #endif
 
-#if SNMP_VECTOR
 #include <vector>
-#endif
 
 /**
  * @namespace SNMP
@@ -113,7 +118,7 @@ struct Error {
     /** Error status. */
     uint8_t _status;
     /** Error index. */
-    uint8_t _index;
+    uint32_t _index;
 };
 
 /**
@@ -836,9 +841,8 @@ public:
     template<typename T>
     void encodeNumeric(T value, Stream &stream) {
         BER::encode(stream);
-        for (uint8_t index = 0; index < _length; ++index) {
-            stream.write(value >> ((_length - index - 1) << 3));
-        }
+        uint8_t bytes[9];
+        stream.write(bytes, storeNumeric<T>(value, bytes, _length) - bytes);
     }
 
     /**
@@ -869,15 +873,17 @@ public:
     template<typename T>
     void decodeNumeric(T *value, Stream &stream, const uint8_t flag = Flag::None) {
         BER::decode(stream, flag);
-        if (T() - 1 < 0) {
-            *value = stream.peek() & 0x80 ? 0xFFFFFFFF : 0;
-        } else {
-            *value = 0;
-        }
-        for (uint8_t index = 0; index < _length; ++index) {
-            *value <<= 8;
-            *value |= static_cast<uint8_t>(stream.read());
+        // Leading bytes beyond 9 only extend the sign
+        uint8_t bytes[9];
+        const unsigned int length = _length;
+        const unsigned int count = std::min<unsigned int>(length, sizeof(bytes));
+        for (unsigned int index = 0; index < length; ++index) {
+            const uint8_t byte = stream.read();
+            if (index + count >= length) {
+                bytes[index + count - length] = byte;
+            }
         }
+        *value = loadNumeric<T>(bytes, count);
     }
 #else
     /**
@@ -906,11 +912,7 @@ public:
      */
     template<typename T>
     uint8_t* encodeNumeric(T value, uint8_t *buffer) {
-        uint8_t *pointer = BER::encode(buffer);
-        for (uint8_t index = 0; index < _length; ++index) {
-            *pointer++ = value >> ((_length - index - 1) << 3);
-        }
-        return pointer;
+        return storeNumeric<T>(value, BER::encode(buffer), _length);
     }
 
     /**
@@ -935,23 +937,17 @@ public:
      * @tparam T C++ type of the numeric value.
      * @param value Numeric value to decode.
      * @param buffer Pointer to the buffer.
-     * @param flag Decoding flag.
      * @return Next position to be read in buffer.
      */
     template<typename T>
-    uint8_t* decodeNumeric(T *value, uint8_t *buffer, const uint8_t flag =
+    uint8_t* decodeNumeric(T *value, uint8_t *buffer, const uint8_t /* flag */ =
             Flag::None) {
         uint8_t *pointer = BER::decode(buffer);
-        if (T() - 1 < 0) {
-            *value = *pointer & 0x80 ? 0xFFFFFFFF : 0;
-        } else {
-            *value = 0;
-        }
-        for (unsigned int index = 0; index < _length; ++index) {
-            *value <<= 8;
-            *value |= static_cast<uint8_t>(*pointer++);
-        }
-        return pointer;
+        const unsigned int length = _length;
+        // Leading bytes beyond 9 only extend the sign
+        const unsigned int count = std::min(length, 9U);
+        *value = loadNumeric<T>(pointer + length - count, count);
+        return pointer + length;
     }
 #endif
 
@@ -963,14 +959,9 @@ public:
      */
     template<typename T>
     void setNegative(T value) {
-        unsigned int length = sizeof(T);
-        for (; length > 1; --length) {
-            uint16_t word = value >> ((length - 2) << 3);
-            if ((word & 0xFF80) != 0xFF80) {
-                break;
-            }
-        }
-        _length = length;
+        // Leading 1 bits but the sign bit are dropped by whole bytes
+        const unsigned int ones = std::countl_one(static_cast<std::make_unsigned_t<T>>(value));
+        _length = sizeof(T) - ((ones - 1) >> 3);
     }
 
     /**
@@ -981,14 +972,81 @@ public:
      */
     template<typename T>
     void setPositive(T value) {
-        unsigned int length = 0;
-        uint8_t carry = 0;
-        do {
-            carry = value & 0x80;
-            value >>= 8;
-            length++;
-        } while (value | carry);
-        _length = length;
+        // Significant bits and a clear sign bit, so a leading 0 if the most significant bit is set
+        const unsigned int bits = (sizeof(T) << 3) - std::countl_zero(static_cast<std::make_unsigned_t<T>>(value));
+        _length = (bits >> 3) + 1;
+    }
+
+    /**
+     * @brief Converts between native and big-endian byte order.
+     *
+     * @param value 64-bit word.
+     * @return Word with the bytes reversed on little-endian CPUs.
+     */
+    static uint64_t bigEndian(const uint64_t value) {
+        if constexpr (std::endian::native == std::endian::big) {
+            return value;
+        } else {
+#ifdef __cpp_lib_byteswap
+            return std::byteswap(value);
+#else
+            return __builtin_bswap64(value);
+#endif
+        }
+    }
+
+    /**
+     * @brief Stores the big-endian content of an integer.
+     *
+     * The value is extended to 64 bits, byte swapped and its low bytes copied
+     * in one unaligned store, with a leading 0 for a ninth byte.
+     *
+     * @tparam T C++ type of the integer.
+     * @param value Integer value.
+     * @param pointer Position to write, at least length bytes.
+     * @param length Count of bytes, from 1 to 9, as set by setPositive() or
+     * setNegative().
+     * @return Next position to be written.
+     */
+    template<typename T>
+    static uint8_t* storeNumeric(T value, uint8_t *pointer, unsigned int length) {
+        using Wide = std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>;
+        const uint64_t word = bigEndian(static_cast<uint64_t>(static_cast<Wide>(value)));
+        if (length > sizeof(word)) {
+            *pointer++ = 0;
+            length = sizeof(word);
+        }
+        uint8_t bytes[sizeof(word)];
+        memcpy(bytes, &word, sizeof(word));
+        memcpy(pointer, bytes + sizeof(word) - length, length);
+        return pointer + length;
+    }
+
+    /**
+     * @brief Loads the big-endian content of an integer.
+     *
+     * The bytes are copied in one unaligned load over a word filled with the
+     * sign of a signed type, then byte swapped. Bytes beyond the size of T are
+     * dropped.
+     *
+     * @tparam T C++ type of the integer.
+     * @param pointer Content.
+     * @param length Count of bytes, at most 9, the first one a leading 0 or sign.
+     * @return Integer value.
+     */
+    template<typename T>
+    static T loadNumeric(const uint8_t *pointer, unsigned int length) {
+        const bool negative = std::is_signed_v<T> && length && (*pointer & 0x80);
+        if (length > sizeof(uint64_t)) {
+            pointer += length - sizeof(uint64_t);
+            length = sizeof(uint64_t);
+        }
+        uint8_t bytes[sizeof(uint64_t)];
+        memset(bytes, negative ? 0xFF : 0, sizeof(bytes));
+        memcpy(bytes + sizeof(bytes) - length, pointer, length);
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        return static_cast<T>(bigEndian(word));
     }
 
     /**
@@ -1018,10 +1076,9 @@ public:
      * - Length size.
      * - Length.
      *
-     * @param refresh Unused.
      * @return BER size.
      */
-    virtual unsigned int getSize(const bool refresh = false) {
+    virtual unsigned int getSize(const bool /* refresh */ = false) {
         _size = _type._size + _length._size + _length;
         return _size;
     }
@@ -1282,6 +1339,10 @@ private:
  * - Length is variable.
  * - Size is variable.
  *
+ * Values shorter than INLINE bytes, e.g. IP or MAC addresses and interface
+ * names, are stored in the object. Longer values are allocated, and the
+ * allocation is reused by setValue() while large enough.
+ *
  * Example
  *
  * | Octet String            | Encoding                      |
@@ -1296,7 +1357,7 @@ public:
      * Creates an OctetStringBER object from a pointer to a null-terminated array of
      * char.
      *
-     * The constructor allocates a char array and copies the value parameter.
+     * The constructor copies the value parameter.
      *
      * @param value OctetStringBER char pointer value.
      */
@@ -1310,7 +1371,7 @@ public:
      * Creates an OctetStringBER object from a pointer to an array of char and the
      * array length.
      *
-     * The constructor allocates a char array and copies the value parameter.
+     * The constructor copies the value parameter.
      *
      * @param value OctetStringBER char pointer value.
      * @param length Value length.
@@ -1320,12 +1381,20 @@ public:
     /**
      * @brief OctetStringBER destructor.
      *
-     *  Releases the char array.
+     *  Releases the char array if allocated.
      */
     virtual ~OctetStringBER() {
-        free(_value);
+        if (_value != _inline) {
+            free(_value);
+        }
     }
 
+    OctetStringBER(const OctetStringBER&) = delete;
+    OctetStringBER& operator=(const OctetStringBER&) = delete;
+
+    /** Size of the inline storage, values up to INLINE - 1 bytes aren't allocated. */
+    static constexpr uint8_t INLINE = 24;
+
 #if SNMP_STREAM
     /**
      * @brief Encodes OctetStringBER to stream.
@@ -1422,7 +1491,7 @@ public:
     }
 
 protected:
-    /** OctetStringBER char array pointer value. */
+    /** OctetStringBER char array pointer value, the inline storage or allocated. */
     char *_value;
 
     /**
@@ -1432,17 +1501,37 @@ protected:
      */
     OctetStringBER(const uint8_t type = Type::OctetString) :
             BER(type) {
-        _value = nullptr;
+        _value = _inline;
+        _inline[0] = 0;
     }
 
     /**
-     * @brief Allocates the char array.
+     * @brief Allocates the char array for the length, null-terminated.
+     *
+     * The inline storage is used if large enough, else the allocation is
+     * reused if large enough.
      */
     void allocate() {
-        free(_value);
-        _value = static_cast<char*>(malloc(_length + 1));
+        if (_length < INLINE) {
+            if (_value != _inline) {
+                free(_value);
+                _value = _inline;
+            }
+        } else if ((_value == _inline) || (_length >= _capacity)) {
+            if (_value != _inline) {
+                free(_value);
+            }
+            _value = static_cast<char*>(malloc(_length + 1));
+            _capacity = _length + 1;
+        }
         _value[_length] = 0;
     }
+
+private:
+    /** Size of the allocated char array. */
+    uint32_t _capacity = 0;
+    /** Inline storage of short values. */
+    char _inline[INLINE];
 };
 
 /**
@@ -1509,42 +1598,19 @@ public:
      * @brief Encodes ObjectIdentifierBER to stream.
      *
      * Type and length are encoded by the inherited BER::encode() then
-     * ObjectIdentifierBER value is encoded.
+     * ObjectIdentifierBER value is encoded by ObjectIdentifier::encode().
      *
      * @param stream Stream to write to.
      */
     virtual void encode(Stream &stream) {
-        unsigned int index = 0;
-        uint32_t subidentifier = 0;
         BER::encode(stream);
-        char *token = const_cast<char*>(_value.c_str());
-        while (token != NULL) {
-            switch (index) {
-            case 0:
-                subidentifier = std::atoi(token);
-                break;
-            case 1:
-                subidentifier = subidentifier * 40 + std::atoi(++token);
-                stream.write(subidentifier);
-                _size++;
-                break;
-                ;
-            default: {
-                subidentifier = std::atol(++token);
-                uint32_t value = subidentifier;
-                uint32_t length = 0;
-                do {
-                    value >>= 7;
-                    length++;
-                } while (value);
-                Base::encode7bits(subidentifier, stream, length);
-                _size += length;
-            }
-                break;
-            }
-            token = strchr(token, '.');
-            index++;
+        ObjectIdentifier oid(_value.c_str());
+        std::vector<uint8_t> content(oid.getLength());
+        oid.encode(content.data());
+        for (const uint8_t byte : content) {
+            stream.write(byte);
         }
+        _size += content.size();
     }
 
     /**
@@ -1585,74 +1651,32 @@ public:
      * @brief Encodes ObjectIdentifierBER to memory buffer.
      *
      * Type and length are encoded by the inherited BER::encode() then
-     * ObjectIdentifierBER value is encoded.
+     * ObjectIdentifierBER value is encoded by ObjectIdentifier::encode().
      *
      * @param buffer Pointer to the buffer.
      * @return Next position to be written in buffer.
      */
     virtual uint8_t* encode(uint8_t *buffer) {
-        unsigned int index = 0;
-        uint32_t subidentifier = 0;
         uint8_t *pointer = BER::encode(buffer);
-        char *token = const_cast<char*>(_value.c_str());
-        while (token != NULL) {
-            switch (index) {
-            case 0:
-                subidentifier = std::atoi(token);
-                break;
-            case 1:
-                subidentifier = subidentifier * 40 + std::atoi(++token);
-                *pointer = subidentifier;
-                break;
-                ;
-            default: {
-                subidentifier = std::atol(++token);
-                uint32_t value = subidentifier;
-                uint32_t length = 0;
-                do {
-                    value >>= 7;
-                    length++;
-                } while (value);
-                Base::encode7bits(subidentifier, pointer, length);
-                pointer += length;
-            }
-                break;
-            }
-            token = strchr(token, '.');
-            index++;
-        }
-        return ++pointer;
+        return ObjectIdentifier(_value.c_str()).encode(pointer);
     }
 
     /**
      * @brief Decodes ObjectIdentifierBER from memory buffer.
      *
      * Type and length are decoded by the inherited BER::decode() then
-     * ObjectIdentifierBER value is decoded.
+     * ObjectIdentifierBER value is decoded by ObjectIdentifier::decode().
      *
      * @param buffer Pointer to the buffer.
      * @return Next position to be read in buffer.
      */
     virtual uint8_t* decode(uint8_t *buffer) {
-        unsigned int index = 0;
-        uint32_t subidentifier = 0;
         uint8_t *pointer = BER::decode(buffer);
-        uint8_t *end = pointer + _length;
-        do {
-            if (index++) {
-                subidentifier = 0;
-                do {
-                    subidentifier <<= 7;
-                    subidentifier += *pointer & 0x7F;
-                } while (*pointer++ & 0x80);
-                _value += "." + std::to_string(subidentifier);
-            } else {
-                subidentifier = *pointer++;
-                _value = std::to_string(subidentifier / 40) + "."
-                        + std::to_string(subidentifier % 40);
-            }
-        } while (pointer < end);
-        return pointer;
+        ObjectIdentifier oid;
+        // A malformed OID decodes as empty
+        oid.decode(pointer, _length);
+        _value = oid.toString().c_str();
+        return pointer + _length;
     }
 #endif
 
@@ -1668,36 +1692,14 @@ public:
     /**
      * @brief Set the ObjectIdentifierBER value.
      *
-     * @note Length is updated.
+     * @note Length is updated, from ObjectIdentifier::getLength(). An invalid
+     * value is encoded as 0.0.
      *
      * @param value ObjectIdentifierBER char pointer value.
      */
     void setValue(const char *value) {
         _value = value;
-        unsigned int index = 0;
-        uint32_t subidentifier = 0;
-        char *token = const_cast<char*>(_value.c_str());
-        while (token != NULL) {
-            switch (index) {
-            case 0:
-                subidentifier = std::atoi(token);
-                break;
-            case 1:
-                subidentifier = subidentifier * 40 + std::atoi(++token);
-                _length++;
-                break;
-            default: {
-                subidentifier = std::atol(++token);
-                do {
-                    subidentifier >>= 7;
-                    _length++;
-                } while (subidentifier);
-            }
-                break;
-            }
-            token = strchr(token, '.');
-            index++;
-        }
+        _length = ObjectIdentifier(value).getLength();
     }
 
 private:
@@ -1709,10 +1711,14 @@ private:
  * @class ArrayBER
  * @brief Base class for BER array of BERs.
  *
- * BERs are stored in an array or a vector depending on the definition of
- * SNMP_VECTORS.
+ * BERs are stored in a vector or in a small array depending on the definition
+ * of SNMP_VECTOR.
+ *
+ * If SNMP_VECTOR is 0, the first U BERs are stored inline, so typical PDUs
+ * allocate nothing for their children. Once full, the array spills to a heap
+ * buffer doubling in capacity, so any count of BERs fits.
  *
- * @tparam U Size of the array. Used only if SNMP_VECTORS is set to 0 or undefined.
+ * @tparam U Inline capacity. Used only if SNMP_VECTOR is set to 0.
  */
 template<const uint8_t U>
 class ArrayBER: public BER {
@@ -1732,18 +1738,19 @@ public:
      * Delete all BERs of the array.
      */
     ~ArrayBER() {
-#if SNMP_VECTOR
-        for (auto ber : _bers) {
-            delete ber;
-        }
-        _bers.clear();
-#else
-        for (uint8_t index = 0; index < _count; ++index) {
+        for (uint32_t index = 0; index < _count; ++index) {
             delete _bers[index];
         }
+#if !SNMP_VECTOR
+        if (_bers != _inline) {
+            delete[] _bers;
+        }
 #endif
     }
 
+    ArrayBER(const ArrayBER&) = delete;
+    ArrayBER& operator=(const ArrayBER&) = delete;
+
 #if SNMP_STREAM
     /**
      * @brief Encodes ArrayBER to stream.
@@ -1755,7 +1762,7 @@ public:
      */
     virtual void encode(Stream &stream) {
         BER::encode(stream);
-        for (uint8_t index = 0; index < _count; ++index) {
+        for (uint32_t index = 0; index < _count; ++index) {
             _bers[index]->encode(stream);
         }
     }
@@ -1805,15 +1812,9 @@ public:
      */
     virtual uint8_t* encode(uint8_t *buffer) {
         uint8_t *pointer = BER::encode(buffer);
-#if SNMP_VECTOR
-        for (auto ber : _bers) {
-            pointer = ber->encode(pointer);
-        }
-#else
-        for (uint8_t index = 0; index < _count; ++index) {
+        for (uint32_t index = 0; index < _count; ++index) {
             pointer = _bers[index]->encode(pointer);
         }
-#endif
         return pointer;
     }
 
@@ -1862,7 +1863,7 @@ public:
     virtual unsigned int getSize(const bool refresh = false) {
         if (refresh) {
             _length = 0;
-            for (uint8_t index = 0; index < _count; ++index) {
+            for (uint32_t index = 0; index < _count; ++index) {
                 _length += _bers[index]->getSize(true);
             }
         }
@@ -1886,7 +1887,7 @@ public:
      *
      * @return Count of BERs.
      */
-    uint8_t count() const {
+    uint32_t count() const {
         return _count;
     }
 
@@ -1902,14 +1903,21 @@ protected:
     BER* add(BER *ber) {
 #if SNMP_VECTOR
         _bers.push_back(ber);
-        _length += ber->getSize();
-        _count++;
 #else
-        if (_count < U) {
-            _bers[_count++] = ber;
-            _length += ber->getSize();
+        if (_count == _capacity) {
+            // Spill to the heap, doubling the capacity
+            _capacity = _capacity ? 2 * _capacity : 4;
+            BER **bers = new BER*[_capacity];
+            memcpy(bers, _bers, _count * sizeof(BER*));
+            if (_bers != _inline) {
+                delete[] _bers;
+            }
+            _bers = bers;
         }
+        _bers[_count] = ber;
 #endif
+        _count++;
+        _length += ber->getSize();
         return ber;
     }
 
@@ -1919,28 +1927,29 @@ protected:
      * The length of the array is updated.
      */
     void remove() {
-#if SNMP_VECTOR
-        if (_bers.size()) {
-            _length -= _bers.back()->getSize();
-            _bers.pop_back();
-            --_count;
-        }
-#else
         if (_count) {
             _length -= _bers[--_count]->getSize();
-        }
+#if SNMP_VECTOR
+            _bers.pop_back();
 #endif
+        }
     }
 
 private:
     /** Count of BERs in the array. */
-    uint8_t _count = 0;
+    uint32_t _count = 0;
 #if SNMP_VECTOR
     /** Vector of BERs.*/
     std::vector<BER*> _bers;
 #else
-    /** Array of U BERs.*/
-    BER *_bers[U];
+    // Members before the inline array keep the same offsets for any U, decoded
+    // sequences being accessed as VarBind and VarBindList
+    /** BERs, the inline array or a heap buffer once spilled. */
+    BER **_bers = _inline;
+    /** Capacity of _bers. */
+    uint32_t _capacity = U;
+    /** Inline array of U BERs. */
+    BER *_inline[U ? U : 1];
 #endif
 
     friend class Message;
@@ -2058,7 +2067,7 @@ public:
     /**
      * @brief Creates an IPAddressBER object.
      *
-     * IP address bytes are stored internally in a bytes array.
+     * IP address bytes are stored inline.
      *
      * @param value IPAddressBER IPAddress value.
      */
@@ -2641,4 +2650,89 @@ public:
     }
 };
 
+/**
+ * @class EncodedBER
+ * @brief BER object wrapping an already encoded BER.
+ *
+ * The encoded bytes are shared, not copied, so a value encoded once, e.g. by a
+ * MIB cache, can be added to many messages. The bytes can also live in memory
+ * owned by another object, e.g. a mapped MIB image, kept alive by the BER.
+ *
+ * @note EncodedBER is write only, it is never created by decoding.
+ */
+class EncodedBER: public BER {
+public:
+    /** Shared encoded bytes type. */
+    using Bytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+    /**
+     * @brief Creates an EncodedBER object.
+     *
+     * @param encoded Encoded BER, type, length and value.
+     */
+    EncodedBER(const Bytes &encoded) :
+            EncodedBER(encoded->data(), encoded->size(), encoded) {
+    }
+
+    /**
+     * @brief Creates an EncodedBER object from bytes owned by another object.
+     *
+     * @param data Encoded BER, type, length and value.
+     * @param size Size of the encoded BER.
+     * @param owner Owner of the bytes, kept alive while the BER exists.
+     */
+    EncodedBER(const uint8_t *data, const size_t size, std::shared_ptr<const void> owner) :
+            BER(size ? data[0] : static_cast<uint8_t>(Type::Null)), _owner(std::move(owner)), _data(data), _bytes(size) {
+    }
+
+#if SNMP_STREAM
+    /**
+     * @brief Encodes EncodedBER to stream.
+     *
+     * @param stream Stream to write to.
+     */
+    virtual void encode(Stream &stream) {
+        stream.write(_data, _bytes);
+    }
+#else
+    /**
+     * @brief Encodes EncodedBER to buffer.
+     *
+     * @param buffer Pointer to the buffer.
+     * @return Next position to be written in buffer.
+     */
+    virtual uint8_t* encode(uint8_t *buffer) {
+        memcpy(buffer, _data, _bytes);
+        return buffer + _bytes;
+    }
+#endif
+
+    /**
+     * @brief Gets the size of the EncodedBER.
+     *
+     * @return Size of the encoded bytes.
+     */
+    virtual unsigned int getSize(const bool /* refresh */ = false) {
+        _size = _bytes;
+        return _size;
+    }
+
+    /**
+     * @brief Gets the encoded bytes.
+     *
+     * @return Pointer to the encoded bytes.
+     */
+    const uint8_t* getData() const {
+        return _data;
+    }
+
+protected:
+    /** Owner of the encoded bytes. */
+    std::shared_ptr<const void> _owner;
+    /** Encoded bytes. */
+    const uint8_t *_data;
+    /** Size of the encoded bytes. */
+    size_t _bytes;
+};
+
 }  // namespace SNMP
@@ -1,7 +1,17 @@
 #pragma once
 
 #include "snmp_message.h"
+#include "snmp_filter.h"
+#include "snmp_ratelimit.h"
+#include "snmp_template.h"
+#include "snmp_value.h"
+#include "snmp_mib.h"
+#include "snmp_table.h"
+#include "snmp_store.h"
+#include "snmp_image.h"
+#include "snmp_subagent.h"
 #include <asio.hpp>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include "arduino_compat/IPAddress.h"
@@ -36,6 +46,111 @@ class SNMP;
 class Agent;
 class Manager;
 
+/**
+ * @class Request
+ * @brief Deferred request context.
+ *
+ * A request owns the received message, so a handler can keep it and respond
+ * later, from any thread. The response is posted to the io_context of the
+ * %SNMP object and sent from there, so a slow request never blocks the
+ * requests received after it.
+ *
+ * A request is responded at most once. Dropping the last reference without
+ * responding drops the request.
+ *
+ * Example
+ *
+ * ```cpp
+ * agent->onRequest([&](std::shared_ptr<SNMP::Request> request) {
+ *     asio::post(pool, [&mib, request]() {
+ *         request->respond(mib.process(request->getMessage()));
+ *     });
+ * });
+ * ```
+ */
+class Request: public std::enable_shared_from_this<Request> {
+public:
+    /**
+     * @brief Creates a request.
+     *
+     * @param snmp %SNMP object which received the message.
+     * @param message Received message.
+     * @param remote IP address of the sender.
+     * @param port UDP port of the sender.
+     */
+    Request(std::weak_ptr<SNMP> snmp, std::unique_ptr<Message> message, const IPAddress &remote,
+            const uint16_t port);
+
+    /**
+     * @brief Gets the received message.
+     *
+     * @return Received message.
+     */
+    const Message* getMessage() const {
+        return _message.get();
+    }
+
+    /**
+     * @brief Gets the IP address of the sender.
+     *
+     * @return IP address of the sender, IPv4 or IPv6.
+     */
+    const IPAddress& getRemote() const {
+        return _remote;
+    }
+
+    /**
+     * @brief Gets the UDP port of the sender.
+     *
+     * @return UDP port of the sender.
+     */
+    uint16_t getPort() const {
+        return _port;
+    }
+
+    /**
+     * @brief Creates an empty response.
+     *
+     * The response has the version, community and request identifier of the
+     * request.
+     *
+     * @return Response message.
+     */
+    std::unique_ptr<Message> createResponse() const;
+
+    /**
+     * @brief Responds to the sender.
+     *
+     * Thread safe. The response is sent from the io_context.
+     *
+     * @param response Response message, nullptr to drop the request.
+     * @return true if the response is posted, false if already responded or if
+     * the %SNMP object is gone.
+     */
+    bool respond(std::unique_ptr<Message> response);
+
+    /**
+     * @brief Checks if the request is responded.
+     *
+     * @return true if responded or dropped.
+     */
+    bool isCompleted() const {
+        return _completed;
+    }
+
+private:
+    /** %SNMP object which received the message. */
+    std::weak_ptr<SNMP> _snmp;
+    /** Received message. */
+    std::unique_ptr<Message> _message;
+    /** IP address of the sender. */
+    IPAddress _remote;
+    /** UDP port of the sender. */
+    uint16_t _port;
+    /** True once responded. */
+    std::atomic<bool> _completed;
+};
+
 /**
  * @class SNMP
  * @brief Base class for Agent and Manager.
@@ -56,7 +171,7 @@ public:
      * ```
      *
      * @param message %SNMP message to process.
-     * @param remote IP address of the sender.
+     * @param remote IP address of the sender, IPv4 or IPv6.
      * @param port UDP port of the sender.
      */
     using MessageHandler = std::function<void(const Message*, const IPAddress, const uint16_t)>;
@@ -66,6 +181,16 @@ public:
      */
     using ErrorHandler = std::function<void(const asio::error_code&)>;
 
+    /**
+     * @brief On request event user handler type.
+     *
+     * Unlike MessageHandler, the handler can keep the request and respond once
+     * done, from any thread.
+     *
+     * @param request Deferred request context.
+     */
+    using RequestHandler = std::function<void(std::shared_ptr<Request>)>;
+
     /**
      * @brief Destructor.
      */
@@ -74,11 +199,20 @@ public:
     /**
      * @brief Initializes network.
      *
+     * Binding to an IPv6 address opens an IPv6 socket. Unless restricted, the
+     * socket is dual-stack: it also serves IPv4 peers, which are reported as
+     * IPv4 addresses.
+     *
+     * ```cpp
+     * agent->initialize(IPAddress(IPv6), Port::SNMP);  // All IPv4 and IPv6 peers
+     * ```
+     *
      * @param bindAddress Local IP address to bind to.
      * @param port UDP port to listen on.
+     * @param v6Only If true, an IPv6 socket serves only IPv6 peers.
      * @return true if success, false if failure.
      */
-    bool initialize(const IPAddress& bindAddress, uint16_t port = 0);
+    bool initialize(const IPAddress& bindAddress, uint16_t port = 0, bool v6Only = false);
 
     /**
      * @brief Starts asynchronous operation.
@@ -118,12 +252,34 @@ public:
      */
     bool send(std::unique_ptr<Message> message, const IPAddress ip, const uint16_t port);
 
+    /**
+     * @brief Sends an already encoded message.
+     *
+     * Copies the message into the outgoing packet, e.g. a ResponseTemplate.
+     *
+     * @param data Encoded message.
+     * @param length Length of the encoded message.
+     * @param ip IP address to send to.
+     * @param port UDP port to send to.
+     * @return true if success, false if failure.
+     */
+    bool send(const uint8_t *data, const size_t length, const IPAddress ip, const uint16_t port);
+
     /**
      * @brief Sets on message event user handler.
      *
      * @param handler Message handler function.
      */
     void onMessage(MessageHandler handler);
+
+    /**
+     * @brief Sets on request event user handler.
+     *
+     * If set, it is called instead of the message handler.
+     *
+     * @param handler Request handler function.
+     */
+    void onRequest(RequestHandler handler);
     
     /**
      * @brief Sets error handler.
@@ -132,6 +288,29 @@ public:
      */
     void onError(ErrorHandler handler);
 
+    /**
+     * @brief Gets the receive pre-filter.
+     *
+     * The filter drops unwanted datagrams before they are decoded.
+     *
+     * @return Receive pre-filter.
+     */
+    Filter& getFilter() {
+        return _filter;
+    }
+
+    /**
+     * @brief Gets the receive rate limiter.
+     *
+     * The rate limiter drops requests from sources exceeding their rate before
+     * they are decoded.
+     *
+     * @return Receive rate limiter.
+     */
+    RateLimiter& getRateLimiter() {
+        return _rateLimiter;
+    }
+
 protected:
     /**
      * @brief Creates an SNMP object.
@@ -161,8 +340,16 @@ protected:
     std::shared_ptr<AsioUDP> _udp;
     /** On message event user handler. */
     MessageHandler _onMessage = nullptr;
+    /** On request event user handler. */
+    RequestHandler _onRequest = nullptr;
     /** Error handler. */
     ErrorHandler _onError = nullptr;
+    /** Receive pre-filter. */
+    Filter _filter;
+    /** Receive rate limiter. */
+    RateLimiter _rateLimiter;
+
+    friend class Request;
 };
 
 /**
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "arduino_compat/IPAddress.h"
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+/**
+ * @class PrefixTrie
+ * @brief Compressed binary prefix trie.
+ *
+ * Each prefix holds a 64-bit mask. Looking up a key returns the union of the
+ * masks of all the prefixes containing the key.
+ *
+ * The trie is path compressed: a node is created only for a stored prefix or
+ * where two stored prefixes diverge, so a lookup visits at most one node per
+ * stored prefix on the path of the key. Nodes are stored in a contiguous vector
+ * and linked by index.
+ *
+ * Keys are up to 128 bits long, to handle both IPv4 and IPv6 addresses.
+ */
+class PrefixTrie {
+public:
+    /** Maximum key length in bytes. */
+    static constexpr uint8_t KEY = 16;
+
+    /**
+     * @brief Inserts a prefix.
+     *
+     * If the prefix already exists, the mask is merged with the existing one.
+     *
+     * @param key Prefix bytes, most significant bit first.
+     * @param bits Prefix length in bits.
+     * @param mask Mask of the prefix.
+     */
+    void insert(const uint8_t *key, const uint8_t bits, const uint64_t mask);
+
+    /**
+     * @brief Matches a key.
+     *
+     * @param key Key bytes, most significant bit first.
+     * @param bits Key length in bits.
+     * @return Union of the masks of all prefixes containing the key.
+     */
+    uint64_t match(const uint8_t *key, const uint8_t bits) const;
+
+    /**
+     * @brief Removes all prefixes.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the count of nodes.
+     *
+     * @return Count of nodes.
+     */
+    size_t size() const {
+        return _nodes.size();
+    }
+
+private:
+    /** Index of a missing node. */
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /**
+     * @struct Node
+     * @brief Trie node.
+     */
+    struct Node {
+        /** Prefix bytes, bits after the prefix length are cleared. */
+        uint8_t _key[KEY];
+        /** Prefix length in bits. */
+        uint8_t _bits;
+        /** Mask of the prefix, 0 for a branching node. */
+        uint64_t _mask;
+        /** Children indexes, by value of the bit following the prefix. */
+        uint32_t _children[2];
+    };
+
+    /** Nodes. */
+    std::vector<Node> _nodes;
+    /** Root index. */
+    uint32_t _root = NONE;
+
+    /**
+     * @brief Creates a node.
+     *
+     * @param key Prefix bytes.
+     * @param bits Prefix length in bits.
+     * @param mask Mask of the prefix.
+     * @return Index of the created node.
+     */
+    uint32_t create(const uint8_t *key, const uint8_t bits, const uint64_t mask);
+};
+
+/**
+ * @class AccessControl
+ * @brief Source address access control list.
+ *
+ * Communities are bound to allowed source prefixes. IPv4 and IPv6 prefixes are
+ * stored in two compressed prefix tries where each prefix holds the mask of
+ * the communities allowed from it, so a check is one community lookup and one
+ * trie walk.
+ *
+ * - If the list is empty, all sources are allowed.
+ * - Otherwise a source is allowed if one of its prefixes is bound to the
+ * community or to any community.
+ *
+ * Up to 63 communities can be bound.
+ *
+ * Example
+ *
+ * ```cpp
+ * AccessControl acl;
+ * acl.allow("public", "10.0.0.0/8");
+ * acl.allow("private", "192.168.1.0/24");
+ * acl.allow(nullptr, "2001:db8::/32");     // Any community
+ * ```
+ */
+class AccessControl {
+public:
+    /**
+     * @brief Allows a community from a source prefix.
+     *
+     * @param community %SNMP community, nullptr for any community.
+     * @param prefix Source prefix, as "address/length" or "address" for a single
+     * host. IPv4 and IPv6 addresses are supported.
+     * @return true if success, false if the prefix is invalid, its length
+     * missing or longer than the address, or too many communities are bound.
+     */
+    bool allow(const char *community, const char *prefix);
+
+    /**
+     * @brief Allows a community from a source prefix.
+     *
+     * @param community %SNMP community, nullptr for any community.
+     * @param address Source address, IPv4 or IPv6.
+     * @param length Prefix length in bits, clamped to the address length.
+     * @return true if success, false if too many communities are bound.
+     */
+    bool allow(const char *community, const IPAddress &address, const uint8_t length = 128);
+
+    /**
+     * @brief Checks a community from a source address.
+     *
+     * @param community %SNMP community.
+     * @param address Source address bytes, most significant first.
+     * @param size Source address size, 4 for IPv4 or 16 for IPv6.
+     * @return true if allowed, false otherwise.
+     */
+    bool check(std::string_view community, const uint8_t *address, const uint8_t size) const;
+
+    /**
+     * @brief Checks a community from a source address.
+     *
+     * @param community %SNMP community.
+     * @param address Source address, IPv4 or IPv6.
+     * @return true if allowed, false otherwise.
+     */
+    bool check(std::string_view community, const IPAddress &address) const {
+        return check(community, address.raw_address(), address.size());
+    }
+
+    /**
+     * @brief Checks if the list is empty.
+     *
+     * @return true if empty, false otherwise.
+     */
+    bool empty() const {
+        return _empty;
+    }
+
+    /**
+     * @brief Removes all entries.
+     */
+    void clear();
+
+private:
+    /** Mask of prefixes allowed for any community. */
+    static constexpr uint64_t ANY = 1;
+    /** Maximum count of bound communities. */
+    static constexpr uint8_t COMMUNITIES = 63;
+
+    /**
+     * @brief Transparent hash to look up communities without allocation.
+     */
+    struct CommunityHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view community) const {
+            return std::hash<std::string_view>()(community);
+        }
+    };
+
+    /** IPv4 prefixes. */
+    PrefixTrie _v4;
+    /** IPv6 prefixes. */
+    PrefixTrie _v6;
+    /** Mask bit of each bound community. */
+    std::unordered_map<std::string, uint64_t, CommunityHash, std::equal_to<>> _communities;
+    /** True if no prefix is set. */
+    bool _empty = true;
+
+    /**
+     * @brief Gets the mask bit of a community, binding it if needed.
+     *
+     * @param community %SNMP community, nullptr for any community.
+     * @return Mask bit, or 0 if too many communities are bound.
+     */
+    uint64_t bind(const char *community);
+
+    /**
+     * @brief Allows a community from a source prefix.
+     *
+     * @param community %SNMP community, nullptr for any community.
+     * @param address Source prefix bytes.
+     * @param size Source prefix size, 4 for IPv4 or 16 for IPv6.
+     * @param length Prefix length in bits.
+     * @return true if success, false if too many communities are bound.
+     */
+    bool allow(const char *community, const uint8_t *address, const uint8_t size, uint8_t length);
+};
+
+} // namespace SNMP
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+/**
+ * @class Epoch
+ * @brief Epoch-based reclamation of published objects.
+ *
+ * Readers access a shared object, e.g. a snapshot published by an atomic
+ * pointer, inside a Guard, without any lock. A writer replaces the object then
+ * retires the old one, which is released once every reader that could still
+ * see it has left its Guard.
+ *
+ * Each Guard holds a reader slot recording the epoch it was entered in. Taking
+ * a slot is a compare-and-swap on a cache line of its own, so readers on
+ * different threads never contend.
+ *
+ * Example
+ *
+ * ```cpp
+ * std::atomic<const Snapshot*> current;
+ * Epoch epoch;
+ *
+ * // Reader
+ * {
+ *     Epoch::Guard guard(epoch);
+ *     const Snapshot *snapshot = current.load();
+ *     ...
+ * }
+ *
+ * // Writer
+ * const Snapshot *old = current.exchange(new Snapshot(...));
+ * epoch.retire(old);
+ * ```
+ */
+class Epoch {
+public:
+    /**
+     * @class Guard
+     * @brief Reader critical section, objects seen inside are not released.
+     */
+    class Guard {
+    public:
+        /**
+         * @brief Enters a reader critical section.
+         *
+         * @param epoch Epoch manager.
+         */
+        Guard(Epoch &epoch) :
+                _epoch(epoch), _slot(epoch.enter()) {
+        }
+
+        /**
+         * @brief Leaves the reader critical section.
+         */
+        ~Guard() {
+            _epoch.leave(_slot);
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        /** Epoch manager. */
+        Epoch &_epoch;
+        /** Reader slot. */
+        size_t _slot;
+    };
+
+    /**
+     * @brief Creates an epoch manager.
+     */
+    Epoch() = default;
+
+    /**
+     * @brief Epoch manager destructor, releases all retired objects.
+     *
+     * @warning No Guard must be alive.
+     */
+    ~Epoch();
+
+    Epoch(const Epoch&) = delete;
+    Epoch& operator=(const Epoch&) = delete;
+
+    /**
+     * @brief Retires an object no longer published.
+     *
+     * @param object Object, deleted once no reader can see it.
+     */
+    template<typename T>
+    void retire(const T *object) {
+        retire(std::function<void()>([object]() {
+            delete object;
+        }));
+    }
+
+    /**
+     * @brief Retires a resource no longer published.
+     *
+     * @param release Function releasing the resource once no reader can see it.
+     */
+    void retire(std::function<void()> release);
+
+    /**
+     * @brief Releases the retired objects no reader can see anymore.
+     *
+     * Called by retire(), only needed to release objects earlier.
+     */
+    void reclaim();
+
+private:
+    /** Count of reader slots. */
+    static constexpr size_t SLOTS = 64;
+    /** Epoch of a free slot. */
+    static constexpr uint64_t IDLE = 0;
+
+    /**
+     * @struct Slot
+     * @brief Reader slot, on a cache line of its own.
+     */
+    struct alignas(64) Slot {
+        /** Epoch the reader entered in, IDLE if free. */
+        std::atomic<uint64_t> _epoch { IDLE };
+    };
+
+    /**
+     * @struct Retired
+     * @brief Retired resource.
+     */
+    struct Retired {
+        /** Epoch the resource was retired in. */
+        uint64_t _epoch;
+        /** Release function. */
+        std::function<void()> _release;
+    };
+
+    /** Global epoch, advanced by each retire. */
+    std::atomic<uint64_t> _epoch { 1 };
+    /** Reader slots. */
+    Slot _slots[SLOTS];
+    /** Retired resources mutex, taken by writers only. */
+    std::mutex _mutex;
+    /** Retired resources, by epoch. */
+    std::vector<Retired> _retired;
+
+    /**
+     * @brief Takes a reader slot.
+     *
+     * @return Slot index.
+     */
+    size_t enter();
+
+    /**
+     * @brief Frees a reader slot.
+     *
+     * @param slot Slot index.
+     */
+    void leave(const size_t slot) {
+        _slots[slot]._epoch.store(IDLE, std::memory_order_release);
+    }
+
+    /**
+     * @brief Releases retired resources without locking.
+     */
+    void release();
+};
+
+} // namespace SNMP
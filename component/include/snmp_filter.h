@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_set>
+#include "snmp_acl.h"
+#include "arduino_compat/IPAddress.h"
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+/**
+ * @struct Header
+ * @brief Helper struct to handle the header of a raw message.
+ *
+ * The header is peeked directly from the received datagram, without decoding
+ * the message into a BER tree.
+ *
+ * @warning Community points into the datagram and is not null-terminated. It is
+ * valid only as long as the datagram is.
+ */
+struct Header {
+    /** %SNMP version. @see Version. */
+    uint8_t _version = 0;
+    /** PDU BER type. @see Type. */
+    uint8_t _type = 0;
+    /** %SNMP community, not null-terminated. */
+    const char *_community = nullptr;
+    /** %SNMP community length. */
+    size_t _communityLength = 0;
+
+    /**
+     * @brief Gets the community as a string view.
+     *
+     * @return %SNMP community.
+     */
+    std::string_view getCommunity() const {
+        return std::string_view(_community, _communityLength);
+    }
+};
+
+/**
+ * @class Filter
+ * @brief Pre-filter of received datagrams.
+ *
+ * The filter runs in the receive path before Message::parse(). It peeks only the
+ * outer SEQUENCE, the version INTEGER and the community OCTET STRING of the
+ * datagram, so an unauthorized packet costs a few byte reads instead of a full
+ * decode.
+ *
+ * - Datagrams that are not a well formed %SNMP header are always dropped.
+ * - Versions other than Version::V1 and Version::V2C are dropped.
+ * - If at least one community is configured, other communities are dropped.
+ * - If the access control list is not empty, communities are dropped from
+ * sources they are not allowed from.
+ *
+ * Example
+ *
+ * ```cpp
+ * agent->getFilter().addCommunity("public");
+ * agent->getFilter().allowSource(IPAddress(192, 168, 0, 10));
+ * agent->getFilter().getAccessControl().allow("public", "10.0.0.0/8");
+ * ```
+ */
+class Filter {
+public:
+    /**
+     * @struct Verdict
+     * @brief Helper struct to handle filter verdicts.
+     */
+    struct Verdict {
+        /**
+         * @brief Enumerates all possible verdicts.
+         */
+        enum : uint8_t {
+            Accept,         /**< 0 */
+            Malformed,      /**< 1 */
+            BadVersion,     /**< 2 */
+            BadCommunity,   /**< 3 */
+            BadSource,      /**< 4 */
+        };
+    };
+
+    /**
+     * @brief Peeks the header of a raw message.
+     *
+     * Checks the outer SEQUENCE and reads version, community and PDU type. All
+     * lengths are checked against the datagram length.
+     *
+     * @param data Datagram.
+     * @param length Datagram length.
+     * @param header Header to fill.
+     * @return true if the header is well formed, false otherwise.
+     */
+    static bool peek(const uint8_t *data, size_t length, Header &header);
+
+    /**
+     * @brief Checks a received datagram.
+     *
+     * @param data Datagram.
+     * @param length Datagram length.
+     * @param remote IP address of the sender.
+     * @return Verdict::Accept if the datagram must be parsed, reason of the
+     * rejection otherwise.
+     */
+    uint8_t check(const uint8_t *data, size_t length, const IPAddress &remote);
+
+    /**
+     * @brief Adds an accepted community.
+     *
+     * @param community %SNMP community.
+     */
+    void addCommunity(const char *community);
+
+    /**
+     * @brief Removes an accepted community.
+     *
+     * @param community %SNMP community.
+     */
+    void removeCommunity(const char *community);
+
+    /**
+     * @brief Allows a source address for any community.
+     *
+     * @param address IP address of the sender.
+     */
+    void allowSource(const IPAddress &address);
+
+    /**
+     * @brief Gets the source address access control list.
+     *
+     * @return Access control list.
+     */
+    AccessControl& getAccessControl() {
+        return _acl;
+    }
+
+    /**
+     * @brief Removes all communities and access control entries.
+     *
+     * The filter then accepts any well formed datagram.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the count of rejected datagrams.
+     *
+     * @return Count of rejected datagrams.
+     */
+    uint32_t getRejected() const {
+        return _rejected;
+    }
+
+private:
+    /**
+     * @brief Transparent hash to look up communities without allocation.
+     */
+    struct CommunityHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view community) const {
+            return std::hash<std::string_view>()(community);
+        }
+    };
+
+    /** Accepted communities. */
+    std::unordered_set<std::string, CommunityHash, std::equal_to<>> _communities;
+    /** Source address access control list. */
+    AccessControl _acl;
+    /** Count of rejected datagrams. */
+    uint32_t _rejected = 0;
+};
+
+} // namespace SNMP
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "snmp_mib.h"
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+/**
+ * @struct Access
+ * @brief Helper struct to handle the MAX-ACCESS of an object.
+ */
+struct Access {
+    /**
+     * @brief Enumerates the MAX-ACCESS values of SMIv2.
+     */
+    enum : uint8_t {
+        NotAccessible,          /**< 0 */
+        AccessibleForNotify,    /**< 1 */
+        ReadOnly,               /**< 2 */
+        ReadWrite,              /**< 3 */
+        ReadCreate,             /**< 4 */
+    };
+};
+
+#if !SNMP_STREAM
+/**
+ * @class ImageBuilder
+ * @brief Compiles instances into a MIB image.
+ *
+ * A MIB image is a flat, relocatable, read-only binary holding instances sorted
+ * by %OID, with their access and encoded value. All references are offsets, so
+ * the image can be mapped anywhere and served by an Image without any parsing
+ * or allocation.
+ *
+ * Layout, all integers in the byte order of the host that built the image:
+ *
+ * - Header: magic "SMIB", byte order mark, version, count of records and
+ * offsets of the records, arcs and values areas.
+ * - Records, sorted by %OID: arcs offset and count, access, value offset and
+ * size.
+ * - Arcs: the arcs of all OIDs, 32-bit each.
+ * - Values: the encoded BER of all values.
+ *
+ * @note Available only when SNMP_STREAM is 0.
+ */
+class ImageBuilder {
+public:
+    /**
+     * @brief Adds an instance.
+     *
+     * @param oid %OID of the instance.
+     * @param value BER value, encoded then deleted.
+     * @param access Access of the instance.
+     * @return true if success, false if the %OID is empty or too long, or
+     * already added.
+     */
+    bool add(const ObjectIdentifier &oid, BER *value, const uint8_t access = Access::ReadOnly);
+
+    /**
+     * @brief Builds the image.
+     *
+     * @return Image bytes.
+     */
+    std::vector<uint8_t> build() const;
+
+private:
+    /**
+     * @struct Object
+     * @brief Instance to compile.
+     */
+    struct Object {
+        /** %OID of the instance. */
+        ObjectIdentifier _oid;
+        /** Access of the instance. */
+        uint8_t _access;
+        /** Encoded value. */
+        std::vector<uint8_t> _value;
+    };
+
+    /** Instances, sorted by %OID. */
+    std::vector<Object> _objects;
+};
+
+/**
+ * @class Image
+ * @brief Provider serving a MIB image in place.
+ *
+ * The image is mapped read-only from a file, or given as a buffer, e.g. a
+ * flash partition. Startup only checks the image, and values are served from
+ * the mapped bytes without copy, so processes serving the same file share its
+ * pages.
+ *
+ * Instances that are not accessible or only accessible for notify are not
+ * served. The image is read-only: writable objects need another provider.
+ *
+ * @note Available only when SNMP_STREAM is 0.
+ *
+ * Example
+ *
+ * ```cpp
+ * // Built offline by tools/mibc
+ * auto image = Image::open("/usr/share/snmp/device.smib");
+ * if (image) {
+ *     mib.add("1.3.6.1.4.1.12345", image);
+ * }
+ * ```
+ */
+class Image: public Provider {
+public:
+    /** Magic bytes of an image. */
+    static constexpr char MAGIC[4] = { 'S', 'M', 'I', 'B' };
+    /** Image format version. */
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * @brief Maps an image file read-only.
+     *
+     * @note Not available on ESP-IDF, use load() with a mapped partition.
+     *
+     * @param path Path of the image file.
+     * @return Image, or nullptr if the file can't be mapped or is not a valid
+     * image.
+     */
+    static std::shared_ptr<Image> open(const char *path);
+
+    /**
+     * @brief Serves an image from a buffer.
+     *
+     * @param data Image bytes, 4-byte aligned, not copied.
+     * @param size Size of the image.
+     * @param owner Owner of the bytes, kept alive by the image and its values.
+     * @return Image, or nullptr if not a valid image.
+     */
+    static std::shared_ptr<Image> load(const uint8_t *data, const size_t size,
+            std::shared_ptr<const void> owner = nullptr);
+
+    /**
+     * @brief Gets the count of instances.
+     *
+     * @return Count of instances, including not accessible ones.
+     */
+    size_t size() const {
+        return _count;
+    }
+
+    virtual BER* get(const ObjectIdentifier &oid);
+    virtual bool next(const ObjectIdentifier &oid, ObjectIdentifier &next);
+    virtual size_t walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances);
+
+private:
+    friend class ImageBuilder;
+
+    /**
+     * @struct Header
+     * @brief Image header.
+     */
+    struct Header {
+        /** Magic bytes. */
+        char _magic[4];
+        /** 0x01020304 in the byte order of the image. */
+        uint32_t _order;
+        /** Format version. */
+        uint32_t _version;
+        /** Count of records. */
+        uint32_t _count;
+        /** Offset of the records. */
+        uint32_t _records;
+        /** Offset of the arcs. */
+        uint32_t _arcs;
+        /** Offset of the values. */
+        uint32_t _values;
+        /** Size of the image. */
+        uint32_t _size;
+    };
+
+    /**
+     * @struct Record
+     * @brief Instance record.
+     */
+    struct Record {
+        /** Index of the first arc. */
+        uint32_t _arcs;
+        /** Count of arcs. */
+        uint16_t _length;
+        /** Access. */
+        uint8_t _access;
+        /** Padding. */
+        uint8_t _reserved;
+        /** Offset of the value in the values area. */
+        uint32_t _value;
+        /** Size of the value. */
+        uint32_t _size;
+    };
+
+    /** Owner of the image bytes. */
+    std::shared_ptr<const void> _owner;
+    /** Records. */
+    const Record *_records;
+    /** Arcs. */
+    const uint32_t *_arcs;
+    /** Values. */
+    const uint8_t *_values;
+    /** Count of records. */
+    uint32_t _count;
+
+    /**
+     * @brief Creates an image provider from a checked image.
+     *
+     * @param data Image bytes.
+     * @param owner Owner of the bytes.
+     */
+    Image(const uint8_t *data, std::shared_ptr<const void> owner);
+
+    /**
+     * @brief Finds the first record not before an %OID.
+     *
+     * @param oid %OID.
+     * @param inclusive true to include a record with this exact %OID.
+     * @return Index of the record, or the count of records if none.
+     */
+    uint32_t find(const ObjectIdentifier &oid, const bool inclusive) const;
+
+    /**
+     * @brief Checks if a record is served.
+     *
+     * @param record Record.
+     * @return true if readable.
+     */
+    static bool readable(const Record &record) {
+        return record._access >= Access::ReadOnly;
+    }
+
+    /**
+     * @brief Gets the %OID of a record.
+     *
+     * @param record Record.
+     * @return %OID.
+     */
+    ObjectIdentifier name(const Record &record) const;
+
+    /**
+     * @brief Creates the value of a record.
+     *
+     * @param record Record.
+     * @return New BER value, sharing the image bytes.
+     */
+    BER* value(const Record &record) const;
+};
+#endif
+
+} // namespace SNMP
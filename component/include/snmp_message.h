@@ -1,5 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
 #include "ber.h"
 #include "arduino_compat.h" // Added compatibility header for millis()
 
@@ -31,9 +38,9 @@ private:
          */
         struct Bulk {
             /** Number of OIDs treated as getRequest. */
-            uint8_t _nonRepeaters;
+            uint32_t _nonRepeaters;
             /** Number of get next operations for each additional OIDs. */
-            uint8_t _maxRepetitions;
+            uint32_t _maxRepetitions;
         };
 
         /**
@@ -90,6 +97,296 @@ public:
     };
 };
 
+#if !SNMP_STREAM
+/**
+ * @struct RawVarBind
+ * @brief Variable binding of a received message, read in place.
+ *
+ * Name and value point into the datagram, nothing is decoded until a getter is
+ * called. Getters of another type than the value return 0 or empty.
+ *
+ * @warning Valid only as long as the message is.
+ */
+struct RawVarBind {
+    /** Content of the name, a BER encoded %OID without type and length. */
+    std::span<const uint8_t> _name;
+    /** BER type of the value. @see Type. */
+    uint8_t _type = 0;
+    /** Content of the value, without type and length. */
+    std::span<const uint8_t> _value;
+
+    /**
+     * @brief Decodes the name.
+     *
+     * @param oid Name.
+     * @return true if success, false if malformed.
+     */
+    bool getName(ObjectIdentifier &oid) const {
+        return oid.decode(_name.data(), _name.size());
+    }
+
+    /**
+     * @brief Checks if the name is in a subtree, without decoding it.
+     *
+     * @param prefix Content of the BER encoded subtree %OID, e.g. from
+     * ObjectIdentifier::encode().
+     * @return true if the name is in the subtree.
+     */
+    bool startsWith(std::span<const uint8_t> prefix) const {
+        return ObjectIdentifier::startsWith(_name.data(), _name.size(), prefix.data(), prefix.size());
+    }
+
+    /**
+     * @brief Gets an Integer value.
+     *
+     * @return Integer value, 0 if not an Integer.
+     */
+    int32_t getInteger() const {
+        if ((_type != Type::Integer) || _value.empty()) {
+            return 0;
+        }
+        int32_t value = _value[0] & 0x80 ? -1 : 0;
+        for (const uint8_t byte : _value) {
+            value = (value << 8) | byte;
+        }
+        return value;
+    }
+
+    /**
+     * @brief Gets a Counter32, Gauge32, TimeTicks or Counter64 value.
+     *
+     * @return Unsigned value, 0 if not an unsigned type.
+     */
+    uint64_t getUnsigned() const {
+        if ((_type != Type::Counter32) && (_type != Type::Gauge32) && (_type != Type::TimeTicks)
+                && (_type != Type::Counter64)) {
+            return 0;
+        }
+        uint64_t value = 0;
+        for (const uint8_t byte : _value) {
+            value = (value << 8) | byte;
+        }
+        return value;
+    }
+
+    /**
+     * @brief Gets the bytes of an OctetString, IPAddress or Opaque value.
+     *
+     * @return Bytes, empty if not a bytes type.
+     */
+    std::string_view getBytes() const {
+        if ((_type != Type::OctetString) && (_type != Type::IPAddress) && (_type != Type::Opaque)) {
+            return std::string_view();
+        }
+        return std::string_view(reinterpret_cast<const char*>(_value.data()), _value.size());
+    }
+
+    /**
+     * @brief Gets a float embedded in an Opaque value.
+     *
+     * @return Float value, 0 if not an OpaqueFloat.
+     */
+    float getFloat() const {
+        static constexpr uint8_t HEADER[] = { 0x9F, 0x78, 0x04 };
+        if ((_type != Type::Opaque) || (_value.size() != sizeof(HEADER) + sizeof(float))
+                || memcmp(_value.data(), HEADER, sizeof(HEADER))) {
+            return 0;
+        }
+        uint32_t bits = 0;
+        for (const uint8_t byte : _value.subspan(sizeof(HEADER))) {
+            bits = (bits << 8) | byte;
+        }
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Decodes an ObjectIdentifier value.
+     *
+     * @param oid %OID.
+     * @return true if success, false if not an ObjectIdentifier or malformed.
+     */
+    bool getOID(ObjectIdentifier &oid) const {
+        if (_type != Type::ObjectIdentifier) {
+            oid = ObjectIdentifier();
+            return false;
+        }
+        return oid.decode(_value.data(), _value.size());
+    }
+};
+
+/**
+ * @class VarBindView
+ * @brief Read-only range over the variable bindings of a received message.
+ *
+ * The view walks the index built when the message was received, so iterating
+ * is a sequential pass over an array, with neither allocation nor virtual call.
+ *
+ * @warning Valid only as long as the message is.
+ *
+ * Example
+ *
+ * ```cpp
+ * agent->onMessage([](const Message *message, const IPAddress remote, const uint16_t port) {
+ *     for (const RawVarBind binding : message->getBindings()) {
+ *         if (binding._type == Type::Counter64) {
+ *             total += binding.getUnsigned();
+ *         }
+ *     }
+ * });
+ * ```
+ */
+class VarBindView {
+public:
+    /**
+     * @struct Entry
+     * @brief Variable binding of an indexed message.
+     *
+     * Offsets are positions in the datagram.
+     */
+    struct Entry {
+        /** Offset of the content of the name. */
+        uint32_t _name;
+        /** Size of the content of the name. */
+        uint32_t _nameLength;
+        /** Offset of the value, type first. */
+        uint32_t _value;
+        /** Size of the value, type and length included. */
+        uint32_t _valueSize;
+        /** BER type of the value. */
+        uint8_t _type;
+        /** Size of the type and length of the value. */
+        uint8_t _header;
+    };
+
+    /**
+     * @class Iterator
+     * @brief Forward iterator yielding RawVarBind values.
+     */
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = RawVarBind;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = RawVarBind;
+
+        Iterator() = default;
+
+        RawVarBind operator*() const {
+            return VarBindView::get(_data, *_entry);
+        }
+
+        Iterator& operator++() {
+            ++_entry;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator iterator = *this;
+            ++_entry;
+            return iterator;
+        }
+
+        bool operator==(const Iterator &other) const {
+            return _entry == other._entry;
+        }
+
+    private:
+        Iterator(const uint8_t *data, const Entry *entry) :
+                _data(data), _entry(entry) {
+        }
+
+        /** Datagram. */
+        const uint8_t *_data = nullptr;
+        /** Current variable binding. */
+        const Entry *_entry = nullptr;
+
+        friend class VarBindView;
+    };
+
+    /**
+     * @brief Gets an iterator to the first variable binding.
+     *
+     * @return Iterator.
+     */
+    Iterator begin() const {
+        return Iterator(_data, _entries);
+    }
+
+    /**
+     * @brief Gets an iterator past the last variable binding.
+     *
+     * @return Iterator.
+     */
+    Iterator end() const {
+        return Iterator(_data, _entries + _count);
+    }
+
+    /**
+     * @brief Gets the count of variable bindings.
+     *
+     * @return Count of variable bindings.
+     */
+    size_t size() const {
+        return _count;
+    }
+
+    /**
+     * @brief Checks if the view is empty.
+     *
+     * @return true if there is no variable binding.
+     */
+    bool empty() const {
+        return _count == 0;
+    }
+
+    /**
+     * @brief Gets a variable binding.
+     *
+     * @param index Index of the variable binding, less than size().
+     * @return Variable binding.
+     */
+    RawVarBind operator[](const size_t index) const {
+        return get(_data, _entries[index]);
+    }
+
+private:
+    /**
+     * @brief Creates a view.
+     *
+     * @param data Datagram.
+     * @param entries Variable bindings.
+     * @param count Count of variable bindings.
+     */
+    VarBindView(const uint8_t *data, const Entry *entries, const size_t count) :
+            _data(data), _entries(entries), _count(count) {
+    }
+
+    /**
+     * @brief Gets the variable binding of an entry.
+     *
+     * @param data Datagram.
+     * @param entry Entry.
+     * @return Variable binding.
+     */
+    static RawVarBind get(const uint8_t *data, const Entry &entry) {
+        return RawVarBind { std::span<const uint8_t>(data + entry._name, entry._nameLength), entry._type,
+                std::span<const uint8_t>(data + entry._value + entry._header, entry._valueSize - entry._header) };
+    }
+
+    /** Datagram. */
+    const uint8_t *_data;
+    /** Variable bindings. */
+    const Entry *_entries;
+    /** Count of variable bindings. */
+    size_t _count;
+
+    friend class Message;
+};
+#endif
+
 /**
  * @class Message
  * @brief SNMP message object.
@@ -98,6 +395,11 @@ public:
  * some members of the class are valid and relevant only if message type is
  * compatible.
  *
+ * A received message is indexed, not decoded: one scan records where the name
+ * and the value of each variable binding are in the datagram, and a value is
+ * decoded only when asked for, by createValue() or getVarBindList(), or read in
+ * place through getBindings().
+ *
  * Example
  *
  * ```cpp
@@ -248,7 +550,7 @@ public:
      *
      * @return Error index.
      */
-    uint8_t getErrorIndex() const {
+    uint32_t getErrorIndex() const {
         return _generic._error._index;
     }
 
@@ -260,7 +562,7 @@ public:
      * @param status Error status.
      * @param index Error index.
      */
-    void setError(const uint8_t status, const uint8_t index) {
+    void setError(const uint8_t status, const uint32_t index) {
         _generic._error._status = mapErrorStatus(status);
         _generic._error._index = index;
     }
@@ -272,7 +574,7 @@ public:
      *
      * @return Number of OIDs treated as getRequest.
      */
-    uint8_t getNonRepeaters() const {
+    uint32_t getNonRepeaters() const {
         return _generic._bulk._nonRepeaters;
     }
 
@@ -283,7 +585,7 @@ public:
      *
      * @param nonRepeaters Number of OIDs treated as getRequest.
      */
-    void setNonRepeaters(const uint8_t nonRepeaters) {
+    void setNonRepeaters(const uint32_t nonRepeaters) {
         _generic._bulk._nonRepeaters = nonRepeaters;
     }
 
@@ -294,7 +596,7 @@ public:
      *
      * @return Number of get next operations for each additional OIDs.
      */
-    uint8_t getMaxRepetition() const {
+    uint32_t getMaxRepetition() const {
         return _generic._bulk._maxRepetitions;
     }
 
@@ -305,7 +607,7 @@ public:
      *
      * @param maxRepetitions Number of get next operations for each additional OIDs.
      */
-    void setMaxRepetitions(const uint8_t maxRepetitions) {
+    void setMaxRepetitions(const uint32_t maxRepetitions) {
         _generic._bulk._maxRepetitions = maxRepetitions;
     }
 
@@ -364,12 +666,74 @@ public:
     /**
      * @brief Gets the variable bindings list.
      *
+     * The list of an indexed message is decoded on the first call, once even
+     * if called from several threads.
+     *
      * @return Variable bindings list.
      */
     VarBindList* getVarBindList() const {
+#if !SNMP_STREAM
+        if (!_data.empty()) {
+            std::call_once(_materialized, [this]() {
+                if (!_varBindList) {
+                    materialize();
+                }
+            });
+        }
+#endif
         return _varBindList;
     }
 
+    /**
+     * @brief Gets the count of variable bindings.
+     *
+     * @return Count of variable bindings.
+     */
+    uint32_t getBindingCount() const;
+
+    /**
+     * @brief Gets the name of a variable binding.
+     *
+     * The name of an indexed message is decoded from the datagram, the list is
+     * not decoded.
+     *
+     * @param index Index of the variable binding.
+     * @param oid Name.
+     * @return true if success, false if the index is out of range or the name is
+     * malformed.
+     */
+    bool getName(const uint32_t index, ObjectIdentifier &oid) const;
+
+    /**
+     * @brief Gets the BER type of the value of a variable binding.
+     *
+     * @param index Index of the variable binding.
+     * @return BER type, 0 if the index is out of range.
+     */
+    uint8_t getValueType(const uint32_t index) const;
+
+#if !SNMP_STREAM
+    /**
+     * @brief Creates the value of a variable binding.
+     *
+     * The value of an indexed message is decoded from the datagram alone.
+     *
+     * @param index Index of the variable binding.
+     * @return New BER value, nullptr if the index is out of range or the type is
+     * unknown.
+     */
+    BER* createValue(const uint32_t index) const;
+
+    /**
+     * @brief Gets the variable bindings of a received message.
+     *
+     * @return View over the datagram, empty for a built message.
+     */
+    VarBindView getBindings() const {
+        return VarBindView(_data.data(), _entries.data(), _entries.size());
+    }
+#endif
+
 private:
     /**
      * @brief Builds the message.
@@ -429,8 +793,9 @@ private:
             break;
         case Type::GetBulkRequest:
             _generic._requestID = static_cast<IntegerBER*>((*pdu)[0])->getValue();
-            _generic._bulk._nonRepeaters = static_cast<IntegerBER*>((*pdu)[1])->getValue();
-            _generic._bulk._maxRepetitions = static_cast<IntegerBER*>((*pdu)[2])->getValue();
+            // Negative values are taken as 0, RFC 3416 section 4.2.3
+            _generic._bulk._nonRepeaters = std::max(static_cast<IntegerBER*>((*pdu)[1])->getValue(), 0);
+            _generic._bulk._maxRepetitions = std::max(static_cast<IntegerBER*>((*pdu)[2])->getValue(), 0);
             break;
         default:
             _generic._requestID = static_cast<IntegerBER*>((*pdu)[0])->getValue();
@@ -496,6 +861,23 @@ private:
         decode(buffer);
         parse();
     }
+
+    /**
+     * @brief Indexes the message from a datagram.
+     *
+     * The header is decoded and the variable bindings are indexed in one scan,
+     * each value checked so it can later be decoded safely. The datagram is then
+     * owned by the message.
+     *
+     * @param data Datagram, taken if indexed.
+     * @return true if success, false if malformed, a value included.
+     */
+    bool index(std::vector<uint8_t> &data);
+
+    /**
+     * @brief Decodes the variable bindings list of an indexed message.
+     */
+    void materialize() const;
 #endif
 
     /**
@@ -539,8 +921,16 @@ private:
     const char *_community;
     /** PDU BER type. @see Type. */
     uint8_t _type;
-    /** Variable bindings list. */
-    VarBindList *_varBindList;
+    /** Variable bindings list, decoded on demand if the message is indexed. */
+    mutable VarBindList *_varBindList;
+#if !SNMP_STREAM
+    /** Received datagram of an indexed message. */
+    std::vector<uint8_t> _data;
+    /** Variable bindings of an indexed message. */
+    std::vector<VarBindView::Entry> _entries;
+    /** Set once the variable bindings list of an indexed message is decoded. */
+    mutable std::once_flag _materialized;
+#endif
 
     friend class SNMP;
 };
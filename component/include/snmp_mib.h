@@ -0,0 +1,604 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "snmp_message.h"
+#include "snmp_oid.h"
+#include <asio.hpp>
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+/**
+ * @struct Instance
+ * @brief Instance found by a walk, with its value.
+ */
+struct Instance {
+    /** %OID of the instance. */
+    ObjectIdentifier _oid;
+    /** New BER value, released by the owner of the instance. */
+    BER *_value;
+};
+
+/**
+ * @struct Lookup
+ * @brief Read of a variable binding, batched with the other ones of a request.
+ */
+struct Lookup {
+    /** %OID of the instance to get, or to walk from. */
+    ObjectIdentifier _oid;
+    /** 0 to get the instance, otherwise maximum count of instances to walk. */
+    size_t _count = 0;
+    /** Instances found, in order: the instance itself for a get, or the instances
+     * strictly after _oid for a walk. */
+    std::vector<Instance> _instances;
+    /** Error::NoError, or Error::GenErr if the provider failed, e.g. timed out. */
+    uint8_t _error = Error::NoError;
+};
+
+/**
+ * @struct Change
+ * @brief Change of an instance requested by a SetRequest.
+ *
+ * The same change is given to all the phases of the SET of an instance.
+ */
+struct Change {
+    /** %OID of the instance. */
+    ObjectIdentifier _oid;
+    /** Requested value, owned by the request. */
+    BER *_value = nullptr;
+    /** Previous value saved by commit for undo, released after cleanup. */
+    std::unique_ptr<BER> _undo;
+};
+
+/**
+ * @class Provider
+ * @brief Source of values for a MIB subtree.
+ *
+ * A provider is registered to a MIB for a subtree and serves all instances
+ * under it. OIDs given to a provider are always full OIDs.
+ *
+ * Writable providers implement the SET phases, called by the MIB for all the
+ * variable bindings of a SetRequest:
+ *
+ * 1. test() of every change checks type, length, value and resources, without
+ * side effect.
+ * 2. commit() of every change applies it, saving what undo() needs.
+ * 3. If a commit fails, undo() of the committed changes, in reverse order.
+ * 4. cleanup() of every tested change.
+ *
+ * @warning If registered with a cache policy, get() and next() are also called
+ * from the MIB refresh threads and must be thread safe.
+ */
+class Provider {
+public:
+    /**
+     * @brief Provider destructor.
+     */
+    virtual ~Provider() = default;
+
+    /**
+     * @brief Gets the value of an instance.
+     *
+     * @param oid %OID of the instance.
+     * @return New BER value, released by the caller, or nullptr if the instance
+     * doesn't exist.
+     */
+    virtual BER* get(const ObjectIdentifier &oid) = 0;
+
+    /**
+     * @brief Finds the instance following an %OID.
+     *
+     * The %OID can be before the subtree of the provider, in which case the first
+     * instance of the subtree is expected.
+     *
+     * @param oid %OID to start from.
+     * @param next First instance strictly after oid, if any.
+     * @return true if found, false if no instance follows oid in the subtree.
+     */
+    virtual bool next(const ObjectIdentifier &oid, ObjectIdentifier &next) = 0;
+
+    /**
+     * @brief Walks the instances following an %OID, with their values.
+     *
+     * Used by GetBulkRequest. The default implementation calls next() and get()
+     * for each instance; providers storing instances in order can scan them
+     * instead.
+     *
+     * @param oid %OID to start from, can be before the subtree.
+     * @param count Maximum count of instances to append.
+     * @param instances Instances strictly after oid in the subtree, appended in
+     * order.
+     * @return Count of appended instances, less than count only if the end of
+     * the subtree is reached.
+     */
+    virtual size_t walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances);
+
+    /**
+     * @brief Reads a batch of variable bindings.
+     *
+     * Called by the MIB with all the lookups of a request routed to the
+     * provider, so a remote provider can answer them in one round trip. The
+     * default implementation calls get() or walk() for each lookup.
+     *
+     * @param lookups Lookups, instances are appended. Walks can start before the
+     * subtree and stop at its end.
+     */
+    virtual void lookup(const std::vector<Lookup*> &lookups);
+
+    /**
+     * @brief Tests a change, first phase of a SET.
+     *
+     * @param change Change.
+     * @return Error::NoError if the change can be committed, or the error status,
+     * e.g. Error::WrongType. Error::NotWritable by default.
+     */
+    virtual uint8_t test(Change& /* change */) {
+        return Error::NotWritable;
+    }
+
+    /**
+     * @brief Applies a tested change, second phase of a SET.
+     *
+     * @param change Change, the previous value is saved in _undo if needed.
+     * @return Error::NoError if success, or Error::CommitFailed.
+     */
+    virtual uint8_t commit(Change& /* change */) {
+        return Error::CommitFailed;
+    }
+
+    /**
+     * @brief Reverts a committed change, after a later commit failed.
+     *
+     * @param change Change.
+     * @return true if success.
+     */
+    virtual bool undo(Change& /* change */) {
+        return false;
+    }
+
+    /**
+     * @brief Releases what test() or commit() reserved, last phase of a SET.
+     *
+     * @param change Change.
+     */
+    virtual void cleanup(Change& /* change */) {
+    }
+};
+
+/**
+ * @class ScalarProvider
+ * @brief Provider of a single instance computed by a callback.
+ */
+class ScalarProvider: public Provider {
+public:
+    /**
+     * @brief Callback type, returns a new BER value or nullptr.
+     */
+    using Callback = std::function<BER*()>;
+
+    /**
+     * @brief Creates a ScalarProvider.
+     *
+     * @param oid %OID of the instance, e.g. sysUpTime.0.
+     * @param callback Value callback.
+     */
+    ScalarProvider(const ObjectIdentifier &oid, Callback callback) :
+            _oid(oid), _callback(callback) {
+    }
+
+    virtual BER* get(const ObjectIdentifier &oid) {
+        return oid == _oid ? _callback() : nullptr;
+    }
+
+    virtual bool next(const ObjectIdentifier &oid, ObjectIdentifier &next) {
+        if (oid < _oid) {
+            next = _oid;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    /** %OID of the instance. */
+    ObjectIdentifier _oid;
+    /** Value callback. */
+    Callback _callback;
+};
+
+/**
+ * @struct CachePolicy
+ * @brief Caching of the values of a provider.
+ *
+ * Cached values are stored encoded and served without calling the provider.
+ *
+ * - A value younger than the TTL is fresh.
+ * - A refresh is started in the background once a value is older than the TTL
+ * minus the refresh-ahead time, so hot values are refreshed before they expire.
+ * - A value older than the TTL is stale but still served, while refreshed, up
+ * to the maximum staleness.
+ * - A missing value, or a value older than the TTL plus the maximum staleness,
+ * is fetched synchronously.
+ *
+ * All times are in milliseconds. A TTL of 0 disables caching.
+ */
+struct CachePolicy {
+    /** Time to live. */
+    uint32_t _ttl = 0;
+    /** Time a value can be served after its TTL. */
+    uint32_t _maxStaleness = 0;
+    /** Time before the end of the TTL a refresh is started. */
+    uint32_t _refreshAhead = 0;
+};
+
+/**
+ * @class MIB
+ * @brief Dispatches requests to providers registered by subtree.
+ *
+ * The MIB answers GetRequest, GetNextRequest, GetBulkRequest and SetRequest
+ * messages. Each variable binding is routed to the provider of its subtree, and
+ * walks cross from a subtree to the next in %OID order. The variable bindings
+ * of a request routed to the same provider are read in one Provider::lookup()
+ * call.
+ *
+ * A SetRequest is applied as a whole or not at all: every change is tested,
+ * then committed, and committed changes are undone if a later one fails. The
+ * providers of the request are locked for its duration, in subtree order, so
+ * SETs to different subtrees run concurrently and GETs never wait for them.
+ *
+ * Identical received GET requests processed concurrently, same version, type
+ * and encoded names, share one evaluation: the first one reads the providers,
+ * the other ones wait for it and get responses built on its values, encoded
+ * once in a shared block, with their own request identifier and community.
+ *
+ * Values of expensive providers can be cached with a CachePolicy. Cached values
+ * are refreshed by a thread pool owned by the MIB, off the network thread, so
+ * requests are served from the cache.
+ *
+ * @note Providers must be registered before requests are processed. Requests
+ * can then be processed from several threads, e.g. deferred Request contexts.
+ * @note Caching requires SNMP_STREAM to be 0, otherwise values are always
+ * fetched from the provider.
+ *
+ * Example
+ *
+ * ```cpp
+ * MIB mib;
+ * mib.add("1.3.6.1.2.1.1.3.0", []() {
+ *     return new TimeTicksBER(millis() / 10);
+ * });
+ * // Expensive, cached 5 seconds, refreshed 1 second before expiry
+ * mib.add("1.3.6.1.2.1.25.1.6.0", []() {
+ *     return new Gauge32BER(countProcesses());
+ * }, {5000, 10000, 1000});
+ *
+ * agent->onMessage([&](const Message *message, const IPAddress remote, const uint16_t port) {
+ *     auto response = mib.process(message);
+ *     if (response) {
+ *         agent->send(std::move(response), remote, port);
+ *     }
+ * });
+ * ```
+ */
+class MIB {
+public:
+    /**
+     * @brief Creates a MIB.
+     *
+     * @param threads Count of threads refreshing cached values.
+     */
+    MIB(const size_t threads = 1);
+
+    /**
+     * @brief MIB destructor.
+     *
+     * Waits for running refreshes, pending ones are dropped.
+     */
+    ~MIB();
+
+    /**
+     * @brief Registers a provider for a subtree.
+     *
+     * @param subtree Dotted %OID of the subtree.
+     * @param provider Provider.
+     * @param policy Cache policy.
+     * @return true if success, false if the subtree is invalid or overlaps a
+     * registered subtree.
+     */
+    bool add(const char *subtree, std::shared_ptr<Provider> provider,
+            const CachePolicy &policy = CachePolicy());
+
+    /**
+     * @brief Registers a scalar computed by a callback.
+     *
+     * @param oid Dotted %OID of the instance, e.g. "1.3.6.1.2.1.1.3.0".
+     * @param callback Value callback.
+     * @param policy Cache policy.
+     * @return true if success, false if the %OID is invalid or overlaps a
+     * registered subtree.
+     */
+    bool add(const char *oid, ScalarProvider::Callback callback,
+            const CachePolicy &policy = CachePolicy());
+
+    /**
+     * @brief Unregisters the provider of a subtree.
+     *
+     * @param subtree Dotted %OID of the subtree.
+     * @return true if success, false if not registered.
+     */
+    bool remove(const char *subtree);
+
+    /**
+     * @brief Processes a request.
+     *
+     * @param request Request message.
+     * @return Response message, or nullptr if the request type is not handled.
+     */
+    std::unique_ptr<Message> process(const Message *request);
+
+    /**
+     * @brief Gets the value of an instance.
+     *
+     * @param oid %OID of the instance.
+     * @return New BER value, NoSuchObjectBER or NoSuchInstanceBER.
+     */
+    BER* get(const ObjectIdentifier &oid);
+
+    /**
+     * @brief Gets the instance following an %OID, across subtrees.
+     *
+     * @param oid %OID to start from.
+     * @param next Following instance.
+     * @return New BER value, or nullptr if the end of the MIB is reached.
+     */
+    BER* next(const ObjectIdentifier &oid, ObjectIdentifier &next);
+
+    /**
+     * @brief Walks the instances following an %OID, across subtrees.
+     *
+     * @param oid %OID to start from.
+     * @param count Maximum count of instances to append.
+     * @param instances Instances strictly after oid, appended in order.
+     * @return Count of appended instances, less than count only if the end of
+     * the MIB is reached.
+     */
+    size_t walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances);
+
+    /**
+     * @brief Reads variable bindings, batched by provider.
+     *
+     * Gets are routed to the provider of their subtree, walks cross from a
+     * subtree to the next. Subtrees are visited in order, each provider once,
+     * with all the lookups at its subtree.
+     *
+     * @param lookups Lookups, instances appended. A get of an instance that
+     * doesn't exist finds none.
+     */
+    void lookup(std::vector<Lookup> &lookups);
+
+    /**
+     * @brief Checks if a BER encoded %OID is in a registered subtree.
+     *
+     * The %OID is compared with the encoded subtrees by
+     * ObjectIdentifier::compare(), without being decoded, e.g. to check a
+     * name of a received message before routing it.
+     *
+     * @param oid Content of the %OID, without type and length.
+     * @param length Size of the content.
+     * @return true if a provider is registered for a subtree containing oid.
+     */
+    bool contains(const uint8_t *oid, const size_t length) const;
+
+private:
+    /** Maximum count of variable bindings in a GetBulkRequest response. */
+    static constexpr uint32_t BINDINGS = 1024;
+
+    /**
+     * @struct Registration
+     * @brief Provider registered for a subtree.
+     */
+    struct Registration {
+        /** Subtree %OID. */
+        ObjectIdentifier _subtree;
+        /** Content of the BER encoded subtree, in the same order. */
+        std::vector<uint8_t> _encoded;
+        /** Provider. */
+        std::shared_ptr<Provider> _provider;
+        /** Cache policy. */
+        CachePolicy _policy;
+        /** Serializes the SETs of the provider. */
+        std::shared_ptr<std::mutex> _lock;
+    };
+
+    /**
+     * @struct Entry
+     * @brief Cached value.
+     */
+    struct Entry {
+        /** Encoded value, nullptr once invalidated by a SET. */
+        EncodedBER::Bytes _value;
+        /** Time of the fetch or of the invalidation in milliseconds. */
+        uint32_t _time = 0;
+        /** True while a refresh is pending. */
+        bool _refreshing = false;
+        /** Time the entry is kept, the TTL plus the maximum staleness. */
+        uint64_t _lifetime = 0;
+        /** Count of invalidations, a value fetched before one is dropped. */
+        uint32_t _generation = 0;
+    };
+
+    /**
+     * @struct Evaluation
+     * @brief Variable bindings of a response, shared by identical requests.
+     */
+    struct Evaluation {
+        /**
+         * @struct Binding
+         * @brief Variable binding.
+         */
+        struct Binding {
+            /** Dotted %OID. */
+            std::string _name;
+            /** Offset of the encoded value in the block. */
+            uint32_t _offset;
+            /** Size of the encoded value, 0 for none. */
+            uint32_t _size;
+        };
+
+        /** Variable bindings. */
+        std::vector<Binding> _bindings;
+        /** Encoded values. */
+        std::vector<uint8_t> _values;
+        /** Error status. */
+        uint8_t _status = Error::NoError;
+        /** Error index. */
+        uint32_t _index = 0;
+    };
+
+    /**
+     * @struct Flight
+     * @brief Evaluation in progress.
+     */
+    struct Flight {
+        /** Request being evaluated, to tell identical requests from colliding signatures. */
+        const Message *_request = nullptr;
+        /** Count of identical requests waiting for the evaluation. */
+        size_t _waiters = 0;
+        /** Evaluation once done, if waited for, nullptr if it failed. */
+        std::shared_ptr<const Evaluation> _result;
+        /** true once done. */
+        bool _done = false;
+    };
+
+    /** Registrations sorted by subtree, subtrees never overlap. */
+    std::vector<Registration> _registrations;
+    /** Cached values. */
+    std::map<ObjectIdentifier, Entry> _cache;
+    /** Cache mutex. */
+    std::mutex _mutex;
+    /** Time of the last purge of expired entries. */
+    uint32_t _purge = 0;
+    /** Refresh threads. */
+    asio::thread_pool _pool;
+    /** Evaluations in progress by hash of the request signature. */
+    std::map<uint64_t, std::shared_ptr<Flight>> _flights;
+    /** Evaluations mutex. */
+    std::mutex _flightsMutex;
+    /** Notified when an evaluation is done. */
+    std::condition_variable _flightsDone;
+
+    /**
+     * @brief Processes a GetRequest, GetNextRequest or GetBulkRequest.
+     *
+     * @param request Request message.
+     * @return Response message.
+     */
+    std::unique_ptr<Message> read(const Message *request);
+
+    /**
+     * @brief Encodes the variable bindings of a response in one block.
+     *
+     * @param response Response message.
+     * @return Evaluation.
+     */
+    static std::shared_ptr<const Evaluation> capture(const Message &response);
+
+    /**
+     * @brief Builds the response of a request from a shared evaluation.
+     *
+     * @param request Request message.
+     * @param evaluation Evaluation of an identical request.
+     * @return Response message.
+     */
+    static std::unique_ptr<Message> respond(const Message *request, const std::shared_ptr<const Evaluation> &evaluation);
+
+    /**
+     * @brief Processes a SetRequest.
+     *
+     * @param request SetRequest message.
+     * @return Response message.
+     */
+    std::unique_ptr<Message> set(const Message *request);
+
+    /**
+     * @brief Finds the registration of the subtree containing an %OID.
+     *
+     * @param oid %OID.
+     * @return Index of the registration, or the count of registrations if none.
+     */
+    size_t find(const ObjectIdentifier &oid) const;
+
+    /**
+     * @brief Finds the registration of the subtree containing a BER encoded
+     * %OID.
+     *
+     * @param oid Content of the %OID, without type and length.
+     * @param length Size of the content.
+     * @return Index of the registration, or the count of registrations if none.
+     */
+    size_t find(const uint8_t *oid, const size_t length) const;
+
+    /**
+     * @brief Finds the first registration a walk from an %OID goes through.
+     *
+     * @param oid %OID.
+     * @return Index of the registration of the subtree containing oid, or of the
+     * first subtree after it, or the count of registrations if none.
+     */
+    size_t first(const ObjectIdentifier &oid) const;
+
+    /**
+     * @brief Gets a value from a provider, through its cache.
+     *
+     * @param registration Registration of the provider.
+     * @param oid %OID of the instance.
+     * @return New BER value, or nullptr if the instance doesn't exist.
+     */
+    BER* value(const Registration &registration, const ObjectIdentifier &oid);
+
+    /**
+     * @brief Fetches and encodes a value from a provider.
+     *
+     * @param provider Provider.
+     * @param oid %OID of the instance.
+     * @return Encoded value, or nullptr if the instance doesn't exist.
+     */
+    static EncodedBER::Bytes fetch(Provider &provider, const ObjectIdentifier &oid);
+
+    /**
+     * @brief Stores a fetched value in the cache.
+     *
+     * Expired entries are purged at most once per second.
+     *
+     * @param oid %OID of the instance.
+     * @param value Encoded value, nullptr to remove the instance.
+     * @param generation Generation of the entry when the fetch started, the
+     * value is dropped if the entry was invalidated since.
+     * @param policy Cache policy of the provider.
+     */
+    void store(const ObjectIdentifier &oid, const EncodedBER::Bytes &value, const uint32_t generation,
+            const CachePolicy &policy);
+
+    /**
+     * @brief Invalidates a cached value changed by a SET.
+     *
+     * The entry is kept without value until it expires, so fetches started
+     * before the invalidation don't store the previous value.
+     *
+     * @param oid %OID of the instance.
+     * @param policy Cache policy of the provider.
+     */
+    void invalidate(const ObjectIdentifier &oid, const CachePolicy &policy);
+};
+
+} // namespace SNMP
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <compare>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+/**
+ * @class ObjectIdentifier
+ * @brief %OID as an array of arcs.
+ *
+ * Unlike the dotted string held by ObjectIdentifierBER, arcs compare in MIB
+ * order: 1.3.6.1.2.1.2 sorts before 1.3.6.1.2.1.10.
+ *
+ * Example
+ *
+ * ```cpp
+ * ObjectIdentifier system("1.3.6.1.2.1.1");
+ * ObjectIdentifier sysName("1.3.6.1.2.1.1.5.0");
+ * sysName.startsWith(system);  // true
+ * system < sysName;            // true
+ * ```
+ */
+class ObjectIdentifier {
+public:
+    /**
+     * @brief Creates an empty %OID.
+     */
+    ObjectIdentifier() = default;
+
+    /**
+     * @brief Creates an %OID from a dotted string.
+     *
+     * @param oid Dotted %OID, e.g. "1.3.6.1.2.1.1.5.0". An invalid string gives
+     * an empty %OID.
+     */
+    ObjectIdentifier(const char *oid) {
+        parse(oid);
+    }
+
+    /**
+     * @brief Creates an %OID from arcs.
+     *
+     * @param arcs Arcs.
+     */
+    ObjectIdentifier(std::initializer_list<uint32_t> arcs) :
+            _arcs(arcs) {
+    }
+
+    /**
+     * @brief Parses a dotted string.
+     *
+     * A leading dot is accepted.
+     *
+     * @param oid Dotted %OID.
+     * @return true if success, false if the string is invalid. The %OID is then
+     * empty.
+     */
+    bool parse(const char *oid);
+
+    /**
+     * @brief Converts to a dotted string.
+     *
+     * @return Dotted %OID.
+     */
+    std::string toString() const;
+
+    /**
+     * @brief Decodes the content of a BER encoded %OID.
+     *
+     * The first subidentifier combines the first two arcs, the others are
+     * base-128 arcs, bit 7 set on all bytes but the last. On x86 CPUs with
+     * AVX2 or SSE4.1, selected at run time, the last bytes of the arcs are
+     * found 32 or 16 bytes at a time and runs of single byte arcs are widened
+     * without a loop.
+     *
+     * @param data Content, without type and length.
+     * @param length Size of the content.
+     * @return true if success, false if malformed or an arc exceeds 32 bits.
+     * The %OID is then empty.
+     */
+    bool decode(const uint8_t *data, const size_t length);
+
+    /**
+     * @brief Gets the size of the BER encoded content.
+     *
+     * @return Size of the content, without type and length.
+     */
+    size_t getLength() const;
+
+    /**
+     * @brief Encodes the content of a BER encoded %OID.
+     *
+     * An empty %OID is encoded as 0.0, a single arc as its first arc followed
+     * by 0.
+     *
+     * @param buffer Pointer to the buffer, at least getLength() bytes.
+     * @return Next position to be written in buffer.
+     */
+    uint8_t* encode(uint8_t *buffer) const;
+
+    /**
+     * @brief Compares the contents of two BER encoded %OIDs, in MIB order.
+     *
+     * The first two arcs are combined so their order is kept, and a longer
+     * base-128 arc is a greater arc. Bytes are compared 8 at a time up to the
+     * first difference, then the lengths of the arcs containing it decide, or
+     * the differing byte if they have the same length. No arc is decoded.
+     *
+     * @param a Content of the first %OID, without type and length.
+     * @param lengthA Size of the first content.
+     * @param b Content of the second %OID, without type and length.
+     * @param lengthB Size of the second content.
+     * @return Same order as comparing the decoded %OIDs, for well formed
+     * contents of at least two arcs.
+     */
+    static std::strong_ordering compare(const uint8_t *a, const size_t lengthA, const uint8_t *b,
+            const size_t lengthB);
+
+    /**
+     * @brief Checks if the content of a BER encoded %OID is in a subtree.
+     *
+     * @param data Content of the %OID, without type and length.
+     * @param length Size of the content.
+     * @param prefix Content of the subtree %OID, of at least two arcs.
+     * @param prefixLength Size of the subtree content.
+     * @return true if prefix is a prefix of the %OID, or equal to it.
+     */
+    static bool startsWith(const uint8_t *data, const size_t length, const uint8_t *prefix,
+            const size_t prefixLength);
+
+    /**
+     * @brief Checks if the %OID is in a subtree.
+     *
+     * @param prefix Subtree %OID.
+     * @return true if prefix is a prefix of this %OID, or equal to it.
+     */
+    bool startsWith(const ObjectIdentifier &prefix) const;
+
+    /**
+     * @brief Appends an arc.
+     *
+     * @param arc Arc to append.
+     */
+    void append(const uint32_t arc) {
+        _arcs.push_back(arc);
+    }
+
+    /**
+     * @brief Appends arcs.
+     *
+     * @param arcs Pointer to the arcs.
+     * @param count Count of arcs.
+     */
+    void append(const uint32_t *arcs, const size_t count) {
+        _arcs.insert(_arcs.end(), arcs, arcs + count);
+    }
+
+    /**
+     * @brief Removes arcs from the end.
+     *
+     * @param size New count of arcs, ignored if not smaller.
+     */
+    void truncate(const size_t size) {
+        if (size < _arcs.size()) {
+            _arcs.resize(size);
+        }
+    }
+
+    /**
+     * @brief Gets the count of arcs.
+     *
+     * @return Count of arcs.
+     */
+    size_t size() const {
+        return _arcs.size();
+    }
+
+    /**
+     * @brief Checks if the %OID is empty.
+     *
+     * @return true if empty.
+     */
+    bool empty() const {
+        return _arcs.empty();
+    }
+
+    /**
+     * @brief Gets the arcs.
+     *
+     * @return Pointer to the arcs.
+     */
+    const uint32_t* data() const {
+        return _arcs.data();
+    }
+
+    /**
+     * @brief Gets an arc.
+     *
+     * @param index Index of the arc.
+     * @return Arc.
+     */
+    uint32_t operator[](const size_t index) const {
+        return _arcs[index];
+    }
+
+    /** Arcs compare lexicographically, which is the MIB order. */
+    auto operator<=>(const ObjectIdentifier &other) const = default;
+    bool operator==(const ObjectIdentifier &other) const = default;
+
+private:
+    /** Arcs. */
+    std::vector<uint32_t> _arcs;
+};
+
+} // namespace SNMP
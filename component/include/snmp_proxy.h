@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "snmp.h"
+#include <asio.hpp>
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+#if !SNMP_STREAM
+/**
+ * @class Proxy
+ * @brief Forwards requests to target agents, caching their responses.
+ *
+ * A proxy fronts agents polled by many managers. Requests received by an Agent
+ * are forwarded to the target agent selected by their community, through a
+ * Manager dedicated to the proxy, and the responses are relayed back.
+ *
+ * - Values answered to GetRequest and GetNextRequest are cached by target,
+ * version and %OID for the TTL, v2c exceptions are never served to v1
+ * managers. A request entirely answered by fresh cached values is responded
+ * locally.
+ * - Identical requests in flight, same target, type, version and variable
+ * bindings, are coalesced: only the first is forwarded, and its response is
+ * relayed to all of them.
+ * - A SetRequest is always forwarded, and removes the cached values of its
+ * instances, read by a GetRequest or as the next instance of a
+ * GetNextRequest.
+ * - Requests not answered within the timeout are dropped, managers retry.
+ *
+ * @note Available only when SNMP_STREAM is 0.
+ *
+ * Example
+ *
+ * ```cpp
+ * auto manager = Manager::create(io_context);
+ * manager->initialize(IPAddress(IPv6), 10161);
+ * manager->start();
+ * auto proxy = Proxy::create(io_context, manager, 5000);
+ * // Managers use community "switch1" to reach 10.0.0.2 with "public"
+ * proxy->add("switch1", IPAddress(10, 0, 0, 2), Port::SNMP, "public");
+ * agent->onRequest([proxy](std::shared_ptr<Request> request) {
+ *     proxy->forward(request);
+ * });
+ * ```
+ */
+class Proxy: public std::enable_shared_from_this<Proxy> {
+public:
+    /**
+     * @brief Creates a proxy.
+     *
+     * Use create(), which also handles the responses of the manager.
+     *
+     * @param io_context IO context of the manager.
+     * @param manager Manager sending forwarded requests.
+     * @param ttl Time to live of cached values in milliseconds, 0 to disable
+     * caching.
+     * @param timeout Time to wait for a target response in milliseconds.
+     */
+    Proxy(asio::io_context &io_context, std::shared_ptr<Manager> manager, const uint32_t ttl = 5000,
+            const uint32_t timeout = 2000);
+
+    /**
+     * @brief Creates a proxy handling the responses of a manager.
+     *
+     * The message handler of the manager is replaced.
+     *
+     * @param io_context IO context of the manager.
+     * @param manager Manager sending forwarded requests, initialized and
+     * started.
+     * @param ttl Time to live of cached values in milliseconds, 0 to disable
+     * caching.
+     * @param timeout Time to wait for a target response in milliseconds.
+     * @return Proxy.
+     */
+    static std::shared_ptr<Proxy> create(asio::io_context &io_context, std::shared_ptr<Manager> manager,
+            const uint32_t ttl = 5000, const uint32_t timeout = 2000);
+
+    /**
+     * @brief Adds a target agent.
+     *
+     * @param community Community of the requests forwarded to the target.
+     * @param address IP address of the target.
+     * @param port UDP port of the target.
+     * @param upstream Community of the forwarded requests, nullptr to keep the
+     * community of the requests.
+     * @return true if success, false if the community is already used.
+     */
+    bool add(const char *community, const IPAddress &address, const uint16_t port = Port::SNMP,
+            const char *upstream = nullptr);
+
+    /**
+     * @brief Forwards a request to its target, or responds from the cache.
+     *
+     * Thread safe. Requests with an unknown community are dropped.
+     *
+     * @param request Deferred request context.
+     */
+    void forward(std::shared_ptr<Request> request);
+
+    /**
+     * @brief Handles a message received by the manager.
+     *
+     * Called by the message handler set by create().
+     *
+     * @param message Received message.
+     * @param remote IP address of the sender.
+     * @param port UDP port of the sender.
+     */
+    void receive(const Message *message, const IPAddress remote, const uint16_t port);
+
+private:
+    /**
+     * @struct Target
+     * @brief Target agent.
+     */
+    struct Target {
+        /** IP address. */
+        IPAddress _address;
+        /** UDP port. */
+        uint16_t _port;
+        /** Community of the forwarded requests, empty to keep the request one. */
+        std::string _community;
+    };
+
+    /**
+     * @struct Entry
+     * @brief Cached variable binding.
+     */
+    struct Entry {
+        /** Name, the following instance for a GetNextRequest. */
+        std::string _name;
+        /** Encoded value. */
+        EncodedBER::Bytes _value;
+        /** Time of the response in milliseconds. */
+        uint32_t _time;
+    };
+
+    /**
+     * @struct Flight
+     * @brief Forwarded request waiting for its response.
+     */
+    struct Flight {
+        /** Coalescing key, empty if not coalesced. */
+        std::string _key;
+        /** Index of the target. */
+        size_t _target;
+        /** Requests waiting for the response, the forwarded one first. */
+        std::vector<std::shared_ptr<Request>> _requests;
+        /** Response timer. */
+        asio::steady_timer _timer;
+    };
+
+    /** Cache key: target index, %SNMP version, request type and requested %OID. */
+    using Key = std::tuple<size_t, uint8_t, uint8_t, ObjectIdentifier>;
+
+    /** IO context. */
+    asio::io_context &_io_context;
+    /** Manager sending forwarded requests. */
+    std::shared_ptr<Manager> _manager;
+    /** Time to live of cached values. */
+    uint32_t _ttl;
+    /** Response timeout. */
+    uint32_t _timeout;
+    /** Target agents. */
+    std::vector<Target> _targets;
+    /** Index of the target of each community. */
+    std::map<std::string, size_t> _communities;
+    /** Cached variable bindings. */
+    std::map<Key, Entry> _cache;
+    /** Time of the last purge of expired entries. */
+    uint32_t _purge = 0;
+    /** Forwarded requests by request identifier. */
+    std::map<int32_t, std::shared_ptr<Flight>> _flights;
+    /** Forwarded requests by coalescing key. */
+    std::map<std::string, std::shared_ptr<Flight>> _coalesced;
+    /** Request identifier of the last forwarded request, wrapping around. */
+    uint32_t _requestID = 0;
+    /** State mutex. */
+    std::mutex _mutex;
+
+    /**
+     * @brief Responds to a request from the cache.
+     *
+     * @param request Request.
+     * @param target Index of the target.
+     * @return true if responded, false if a value is missing or expired.
+     */
+    bool respond(const std::shared_ptr<Request> &request, const size_t target);
+
+    /**
+     * @brief Drops a forwarded request after its timeout.
+     *
+     * @param id Request identifier of the forwarded request.
+     */
+    void expire(const int32_t id);
+};
+#endif
+
+} // namespace SNMP
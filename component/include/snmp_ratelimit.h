@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "arduino_compat/IPAddress.h"
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+/**
+ * @class RateLimiter
+ * @brief Per source address token bucket rate limiter.
+ *
+ * Each source address owns a token bucket refilled at a given rate, up to a
+ * given burst. A request consumes one token and is dropped if the bucket is
+ * empty, so a single noisy peer can't starve the others.
+ *
+ * Buckets are stored in a fixed-size set-associative hash table. A set holds
+ * four buckets and fits in a 64-byte cache line, so a lookup touches a single
+ * cache line. When a set is full, the least recently seen bucket is reused.
+ * A bucket idle long enough to be refilled up to the burst is identical to a
+ * new one, so aged buckets are reused without changing the limiting.
+ *
+ * The limiter is disabled until a rate is set.
+ *
+ * Example
+ *
+ * ```cpp
+ * // 50 requests per second per source, bursts of 100 requests
+ * agent->getRateLimiter().setRate(50, 100);
+ * ```
+ */
+class RateLimiter {
+public:
+    /**
+     * @brief Creates a rate limiter.
+     *
+     * @param sets Count of sets, rounded up to a power of 2. Each set holds 4
+     * buckets.
+     */
+    RateLimiter(size_t sets = 256);
+
+    /**
+     * @brief Sets rate and burst.
+     *
+     * All buckets are reset.
+     *
+     * @param rate Requests allowed per second and per source, 0 to disable.
+     * @param burst Maximum requests allowed at once per source.
+     */
+    void setRate(const uint32_t rate, const uint32_t burst);
+
+    /**
+     * @brief Checks if a request from a source is allowed.
+     *
+     * Consumes one token from the source bucket.
+     *
+     * @param address Source address.
+     * @param now Current time in milliseconds.
+     * @return true if allowed, false if the request must be dropped.
+     */
+    bool allow(const IPAddress &address, const uint32_t now);
+
+    /**
+     * @brief Checks if a request from a source is allowed now.
+     *
+     * @param address Source address.
+     * @return true if allowed, false if the request must be dropped.
+     */
+    bool allow(const IPAddress &address);
+
+    /**
+     * @brief Gets the count of dropped requests.
+     *
+     * @return Count of dropped requests.
+     */
+    uint32_t getDropped() const {
+        return _dropped;
+    }
+
+private:
+    /** Count of buckets in a set. */
+    static constexpr uint8_t WAYS = 4;
+    /** Tokens are stored in thousandths of token. */
+    static constexpr uint32_t TOKEN = 1000;
+
+    /**
+     * @struct Bucket
+     * @brief Token bucket of a source.
+     */
+    struct Bucket {
+        /** Source key, 0 if the bucket is free. */
+        uint64_t _key;
+        /** Tokens, in thousandths of token. */
+        uint32_t _tokens;
+        /** Time of the last refill in milliseconds. */
+        uint32_t _time;
+    };
+
+    /**
+     * @struct Set
+     * @brief Cache line aligned set of buckets.
+     */
+    struct alignas(64) Set {
+        Bucket _buckets[WAYS];
+    };
+
+    /** Sets of buckets. */
+    std::vector<Set> _sets;
+    /** Mask to get a set index from a hash. */
+    uint32_t _mask;
+    /** Refill rate, in thousandths of token per millisecond. */
+    uint32_t _rate = 0;
+    /** Bucket capacity, in thousandths of token. */
+    uint32_t _capacity = 0;
+    /** Count of dropped requests. */
+    uint32_t _dropped = 0;
+
+    /**
+     * @brief Resets all buckets.
+     */
+    void reset();
+
+    /**
+     * @brief Computes the key of a source address.
+     *
+     * IPv4 keys are the address itself, IPv6 keys are a 64-bit hash of the
+     * address. Both are never 0 and never collide with each other.
+     *
+     * @param address Source address.
+     * @return Source key.
+     */
+    static uint64_t key(const IPAddress &address);
+};
+
+} // namespace SNMP
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "snmp_epoch.h"
+#include "snmp_mib.h"
+#include <asio.hpp>
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+#if !SNMP_STREAM
+/**
+ * @class Store
+ * @brief Provider of encoded values read from immutable snapshots.
+ *
+ * Values are kept encoded in a snapshot sorted by %OID. Writers never modify a
+ * snapshot: an Update is applied to a copy, which is then published with an
+ * atomic pointer swap, and the previous snapshot is released by an Epoch once
+ * no reader uses it anymore.
+ *
+ * Readers, i.e. get(), next() and walk(), never take a lock and always see a
+ * consistent snapshot, so requests can be processed on several io_context
+ * threads while values are updated.
+ *
+ * An update that only changes existing instances, e.g. counters, shares the
+ * sorted %OID array of the previous snapshot and only copies the values.
+ * Grouping changes into one Update publishes them together and amortizes the
+ * copy.
+ *
+ * @note All instances must be in the subtree the store is registered for.
+ * @note Available only when SNMP_STREAM is 0.
+ *
+ * Example
+ *
+ * ```cpp
+ * auto store = std::make_shared<Store>();
+ * mib.add("1.3.6.1.2.1.2.2.1", store);
+ *
+ * // Collector thread
+ * Store::Update update;
+ * for (uint32_t index = 1; index <= count; ++index) {
+ *     ObjectIdentifier oid = {1, 3, 6, 1, 2, 1, 2, 2, 1, 10, index};
+ *     update.set(oid, new Counter32BER(inOctets[index]));
+ * }
+ * store->apply(update);
+ * ```
+ */
+class Store: public Provider {
+public:
+    /**
+     * @class Update
+     * @brief Changes published together.
+     */
+    class Update {
+    public:
+        /**
+         * @brief Sets the value of an instance, added if missing.
+         *
+         * @param oid %OID of the instance.
+         * @param value BER value, encoded then deleted.
+         */
+        void set(const ObjectIdentifier &oid, BER *value);
+
+        /**
+         * @brief Removes an instance.
+         *
+         * @param oid %OID of the instance.
+         */
+        void remove(const ObjectIdentifier &oid);
+
+        /**
+         * @brief Checks if the update has no change.
+         *
+         * @return true if empty.
+         */
+        bool empty() const {
+            return _changes.empty();
+        }
+
+        /**
+         * @struct Change
+         * @brief Change of an instance.
+         */
+        struct Change {
+            /** %OID of the instance. */
+            ObjectIdentifier _oid;
+            /** Encoded value, nullptr to remove the instance. */
+            EncodedBER::Bytes _value;
+        };
+
+    private:
+        friend class Store;
+
+        /** Changes, in call order. */
+        std::vector<Change> _changes;
+    };
+
+    /**
+     * @brief Creates an empty store.
+     */
+    Store();
+
+    /**
+     * @brief Store destructor.
+     */
+    virtual ~Store();
+
+    Store(const Store&) = delete;
+    Store& operator=(const Store&) = delete;
+
+    /**
+     * @brief Applies and publishes an update.
+     *
+     * Writers are serialized, readers are never blocked. The update is emptied.
+     *
+     * @param update Update, the last change of an instance wins.
+     */
+    void apply(Update &update);
+
+    /**
+     * @brief Sets and publishes the value of an instance.
+     *
+     * @param oid %OID of the instance.
+     * @param value BER value, encoded then deleted.
+     */
+    void set(const ObjectIdentifier &oid, BER *value);
+
+    /**
+     * @brief Removes and publishes an instance.
+     *
+     * @param oid %OID of the instance.
+     */
+    void remove(const ObjectIdentifier &oid);
+
+    /**
+     * @brief Gets the count of instances.
+     *
+     * @return Count of instances in the current snapshot.
+     */
+    size_t size();
+
+    /**
+     * @brief Saves all instances to a snapshot file.
+     *
+     * The file is written aside then renamed, so a crash never leaves a
+     * partial snapshot.
+     *
+     * @param path Path of the snapshot file.
+     * @return true if success.
+     */
+    bool save(const char *path);
+
+    /**
+     * @brief Restores the instances of a snapshot file.
+     *
+     * The file is mapped and its frames applied in order, as one update. A
+     * truncated or corrupted frame, e.g. an append interrupted by a crash, ends
+     * the restore: the frames before it are kept.
+     *
+     * @param path Path of the snapshot file.
+     * @return true if at least the first frame is valid.
+     */
+    bool restore(const char *path);
+
+    virtual BER* get(const ObjectIdentifier &oid);
+    virtual bool next(const ObjectIdentifier &oid, ObjectIdentifier &next);
+    virtual size_t walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances);
+
+private:
+    friend class StoreWriter;
+
+    /**
+     * @struct Snapshot
+     * @brief Immutable version of the instances.
+     */
+    struct Snapshot {
+        /** Instance OIDs, sorted, shared by snapshots with the same instances. */
+        std::shared_ptr<const std::vector<ObjectIdentifier>> _names;
+        /** Encoded values, by position in the names. */
+        std::vector<EncodedBER::Bytes> _values;
+    };
+
+    /** Published snapshot. */
+    std::atomic<const Snapshot*> _current;
+    /** Reclamation of replaced snapshots. */
+    Epoch _epoch;
+    /** Writers mutex. */
+    std::mutex _mutex;
+
+    /**
+     * @brief Publishes sorted changes without duplicates.
+     *
+     * @param changes Changes, sorted by %OID.
+     * @param reset true to drop the current instances first.
+     */
+    void publish(std::vector<Update::Change> &changes, const bool reset);
+
+    /**
+     * @brief Gets the instances of the current snapshot.
+     *
+     * @param names Sorted instance OIDs.
+     * @param values Encoded values, by position in names.
+     */
+    void capture(std::shared_ptr<const std::vector<ObjectIdentifier>> &names,
+            std::vector<EncodedBER::Bytes> &values);
+};
+
+/**
+ * @class StoreWriter
+ * @brief Saves a Store to a snapshot file periodically, in the background.
+ *
+ * The snapshot file starts with a full frame of all instances, then each write
+ * appends a delta frame of the instances changed or removed since the last
+ * write. Every frame has a CRC-32. After a number of deltas, the file is
+ * compacted by writing a full frame aside and renaming it.
+ *
+ * Unchanged values are shared between Store snapshots, so finding the changes
+ * is a comparison of pointers.
+ *
+ * @note Available only when SNMP_STREAM is 0.
+ *
+ * Example
+ *
+ * ```cpp
+ * auto store = std::make_shared<Store>();
+ * store->restore("/var/lib/agent/store.snap");
+ * // Every 10 seconds, compacted every 32 writes
+ * StoreWriter writer(store, "/var/lib/agent/store.snap", 10000, 32);
+ * ```
+ */
+class StoreWriter {
+public:
+    /**
+     * @brief Creates a writer and starts its timer.
+     *
+     * @param store Store to save.
+     * @param path Path of the snapshot file.
+     * @param period Time between writes in milliseconds.
+     * @param compaction Count of delta frames before the file is compacted.
+     */
+    StoreWriter(std::shared_ptr<Store> store, const char *path, const uint32_t period = 10000,
+            const uint32_t compaction = 32);
+
+    /**
+     * @brief Stops the timer and writes the last changes.
+     */
+    ~StoreWriter();
+
+    StoreWriter(const StoreWriter&) = delete;
+    StoreWriter& operator=(const StoreWriter&) = delete;
+
+    /**
+     * @brief Writes the changes now.
+     *
+     * @return true if success or nothing changed.
+     */
+    bool write();
+
+private:
+    /** Store to save. */
+    std::shared_ptr<Store> _store;
+    /** Path of the snapshot file. */
+    std::string _path;
+    /** Time between writes in milliseconds. */
+    uint32_t _period;
+    /** Count of delta frames before compaction. */
+    uint32_t _compaction;
+    /** Count of delta frames in the file. */
+    uint32_t _deltas = 0;
+    /** Instance OIDs written last, nullptr before the first full frame. */
+    std::shared_ptr<const std::vector<ObjectIdentifier>> _names;
+    /** Values written last. */
+    std::vector<EncodedBER::Bytes> _values;
+    /** Serializes writes. */
+    std::mutex _mutex;
+    /** Writer thread. */
+    asio::thread_pool _pool;
+    /** Write timer. */
+    asio::steady_timer _timer;
+
+    /**
+     * @brief Schedules the next write.
+     */
+    void schedule();
+};
+#endif
+
+} // namespace SNMP
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "snmp_mib.h"
+#include <asio.hpp>
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+#if !SNMP_STREAM && !defined(ESP_PLATFORM)
+/**
+ * @class Subagent
+ * @brief Serves a MIB to master agents over a Unix domain socket.
+ *
+ * A subagent lets a process own its subtrees while a master agent, the only one
+ * listening on the %SNMP port, fronts all the processes of a host. The master
+ * registers a SubagentProvider for each subtree of the subagent.
+ *
+ * Connections are persistent. Each message carries all the lookups of a
+ * request for the subagent, answered by MIB::lookup() in one response.
+ *
+ * Messages, all integers 32-bit in host byte order:
+ *
+ * - Size of the body, then the body.
+ * - Request body: identifier, count of lookups, then for each lookup the
+ * maximum count of instances to walk, 0 for a get, and the count of arcs
+ * followed by the arcs.
+ * - Response body: identifier of the request, count of lookups, then for each
+ * lookup its error status and the count of instances found, and for each
+ * instance the count of arcs followed by the arcs, and the size of the encoded
+ * value followed by the value.
+ *
+ * @note Available only when SNMP_STREAM is 0, and not on ESP-IDF.
+ *
+ * Example
+ *
+ * ```cpp
+ * // Subagent process
+ * MIB mib;
+ * mib.add("1.3.6.1.4.1.12345.1", table);
+ * auto subagent = Subagent::create(io_context, mib);
+ * subagent->start("/run/snmp/storage.sock");
+ * io_context.run();
+ * ```
+ */
+class Subagent: public std::enable_shared_from_this<Subagent> {
+public:
+    /** Maximum size of a message body. */
+    static constexpr uint32_t MAX_MESSAGE = 1 << 20;
+
+    /**
+     * @brief Creates a subagent.
+     *
+     * @param io_context IO context serving the connections.
+     * @param mib MIB to serve, must outlive the subagent.
+     */
+    Subagent(asio::io_context &io_context, MIB &mib);
+
+    /**
+     * @brief Creates a subagent.
+     *
+     * @param io_context IO context serving the connections.
+     * @param mib MIB to serve, must outlive the subagent.
+     * @return Subagent.
+     */
+    static std::shared_ptr<Subagent> create(asio::io_context &io_context, MIB &mib);
+
+    /**
+     * @brief Listens for master agents.
+     *
+     * A stale socket file left at the path is replaced. Connections aren't
+     * authenticated, so the socket is created accessible to the owner only by
+     * default.
+     *
+     * @param path Path of the socket.
+     * @param mode Permissions of the socket file, e.g. 0660 to allow a group.
+     * @return true if success.
+     */
+    bool start(const char *path, const unsigned int mode = 0600);
+
+    /**
+     * @brief Stops listening, established connections are closed.
+     *
+     * @return true if success.
+     */
+    bool stop();
+
+private:
+    class Session;
+
+    /** Served MIB. */
+    MIB &_mib;
+    /** Listening socket. */
+    asio::local::stream_protocol::acceptor _acceptor;
+    /** Open connections. */
+    std::vector<std::weak_ptr<Session>> _sessions;
+
+    /**
+     * @brief Accepts the next connection.
+     */
+    void accept();
+
+    /**
+     * @brief Answers a request.
+     *
+     * @param request Request body.
+     * @param response Response message, size then body.
+     * @return true if success, false if the request is malformed.
+     */
+    bool answer(const std::vector<uint8_t> &request, std::vector<uint8_t> &response);
+};
+
+/**
+ * @class SubagentProvider
+ * @brief Provider forwarding the lookups of its subtree to a Subagent.
+ *
+ * All the lookups of a request routed to the provider are sent in one message
+ * over a persistent connection, opened on first use and after a failure.
+ *
+ * A subagent not answering within the timeout fails the lookups, answered with
+ * genErr, and its connection is closed so a late response can't be mistaken
+ * for the next one.
+ *
+ * Lookups block the calling thread until the response or the timeout, so the
+ * master agent should process requests in deferred Request contexts on a
+ * thread pool. Requests to the same subagent are serialized.
+ *
+ * @note Available only when SNMP_STREAM is 0, and not on ESP-IDF. SETs are not
+ * forwarded, the subtree is read-only.
+ *
+ * Example
+ *
+ * ```cpp
+ * // Master agent process, one subagent per subtree, 500 ms timeout
+ * mib.add("1.3.6.1.4.1.12345.1", std::make_shared<SubagentProvider>("/run/snmp/storage.sock", 500));
+ * agent->onRequest([&](std::shared_ptr<Request> request) {
+ *     asio::post(pool, [&mib, request]() {
+ *         request->respond(mib.process(request->getMessage()));
+ *     });
+ * });
+ * ```
+ */
+class SubagentProvider: public Provider {
+public:
+    /**
+     * @brief Creates a provider for a subagent.
+     *
+     * @param path Path of the subagent socket.
+     * @param timeout Response timeout in milliseconds.
+     */
+    SubagentProvider(const char *path, const uint32_t timeout = 1000);
+
+    virtual BER* get(const ObjectIdentifier &oid);
+    virtual bool next(const ObjectIdentifier &oid, ObjectIdentifier &next);
+    virtual size_t walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances);
+    virtual void lookup(const std::vector<Lookup*> &lookups);
+
+private:
+    /** Path of the subagent socket. */
+    std::string _path;
+    /** Response timeout in milliseconds. */
+    uint32_t _timeout;
+    /** Identifier of the last request. */
+    uint32_t _id = 0;
+    /** Serializes requests. */
+    std::mutex _mutex;
+    /** IO context of the connection, run by the requesting thread. */
+    asio::io_context _io_context;
+    /** Connection, open once connected. */
+    asio::local::stream_protocol::socket _socket;
+
+    /**
+     * @brief Sends a request and waits for its response.
+     *
+     * @param request Request message, size then body.
+     * @param response Response body.
+     * @return true if success, false if failed or timed out.
+     */
+    bool exchange(const std::vector<uint8_t> &request, std::vector<uint8_t> &response);
+};
+#endif
+
+} // namespace SNMP
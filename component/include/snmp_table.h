@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "snmp_mib.h"
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+/**
+ * @class Table
+ * @brief Conceptual table stored by column.
+ *
+ * Rows are identified by their index, the arcs following the column arc in
+ * the %OID of an instance. Each column is a contiguous typed array indexed by
+ * row slot (structure of arrays), and a sorted array of slots gives the index
+ * order. So:
+ *
+ * - GetRequest is a binary search on the index plus an array read.
+ * - GetNextRequest is a binary search plus an array read.
+ * - GetBulkRequest is a binary search then a sequential scan.
+ *
+ * Row and column handles are stable: a removed row slot is reused only by a
+ * later added row. Keeping the row handles lets a collector refresh a whole
+ * column with one bulk call, e.g. setUnsigned(column, rows, values, count).
+ *
+ * Supported column types are Integer, Counter32, Gauge32, TimeTicks and
+ * IPAddress, stored as 32-bit values, Counter64, stored as 64-bit values, and
+ * OctetString.
+ *
+ * The table is thread safe: reads share a lock, writes are exclusive.
+ *
+ * Example
+ *
+ * ```cpp
+ * // IF-MIB::ifEntry
+ * auto table = std::make_shared<Table>("1.3.6.1.2.1.2.2.1");
+ * uint32_t ifIndex = table->addColumn(1, Type::Integer);
+ * uint32_t ifDescr = table->addColumn(2, Type::OctetString);
+ * uint32_t ifInOctets = table->addColumn(10, Type::Counter32);
+ *
+ * uint32_t row = table->addRow({1});
+ * table->setInteger(row, ifIndex, 1);
+ * table->setString(row, ifDescr, "eth0", 4);
+ * table->setUnsigned(row, ifInOctets, 123456);
+ *
+ * mib.add("1.3.6.1.2.1.2.2.1", table);
+ * ```
+ */
+class Table: public Provider {
+public:
+    /** Invalid row or column handle. */
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /**
+     * @brief Creates a table.
+     *
+     * @param entry Dotted %OID of the table entry, e.g. "1.3.6.1.2.1.2.2.1".
+     */
+    Table(const char *entry);
+
+    /**
+     * @brief Adds a column.
+     *
+     * Existing rows get a zero or empty value.
+     *
+     * @param arc Column arc, following the entry %OID.
+     * @param type Column BER type.
+     * @return Column handle, or NONE if the type is not supported or the arc is
+     * already used.
+     */
+    uint32_t addColumn(const uint32_t arc, const uint8_t type);
+
+    /**
+     * @brief Adds a row.
+     *
+     * Values are set to zero or empty.
+     *
+     * @param index Row index.
+     * @return Row handle, of the existing row if the index is already used, or
+     * NONE if the index is empty.
+     */
+    uint32_t addRow(const ObjectIdentifier &index);
+
+    /**
+     * @brief Finds a row.
+     *
+     * @param index Row index.
+     * @return Row handle, or NONE if not found.
+     */
+    uint32_t findRow(const ObjectIdentifier &index) const;
+
+    /**
+     * @brief Removes a row.
+     *
+     * @param row Row handle.
+     * @return true if success, false if the row doesn't exist.
+     */
+    bool removeRow(const uint32_t row);
+
+    /**
+     * @brief Gets the count of rows.
+     *
+     * @return Count of rows.
+     */
+    size_t getRowCount() const;
+
+    /**
+     * @brief Sets an Integer value.
+     *
+     * @param row Row handle.
+     * @param column Column handle of an Integer column.
+     * @param value Value.
+     * @return true if success, false if the row, the column or the type is invalid.
+     */
+    bool setInteger(const uint32_t row, const uint32_t column, const int32_t value);
+
+    /**
+     * @brief Sets an unsigned value.
+     *
+     * @param row Row handle.
+     * @param column Column handle of a Counter32, Gauge32, TimeTicks, IPAddress
+     * or Counter64 column.
+     * @param value Value, truncated to 32 bits except for Counter64.
+     * @return true if success, false if the row, the column or the type is invalid.
+     */
+    bool setUnsigned(const uint32_t row, const uint32_t column, const uint64_t value);
+
+    /**
+     * @brief Sets an OctetString value.
+     *
+     * @param row Row handle.
+     * @param column Column handle of an OctetString column.
+     * @param value Value bytes.
+     * @param length Length of the value.
+     * @return true if success, false if the row, the column or the type is invalid.
+     */
+    bool setString(const uint32_t row, const uint32_t column, const char *value, const size_t length);
+
+    /**
+     * @brief Sets Integer values of many rows at once.
+     *
+     * The values are written in one pass under a single lock, so readers see
+     * all of them or none.
+     *
+     * @param column Column handle of an Integer column.
+     * @param rows Row handles.
+     * @param values Values, by position in rows.
+     * @param count Count of rows and values.
+     * @return true if success, false if the column, the type or any row is
+     * invalid, in which case nothing is written.
+     */
+    bool setInteger(const uint32_t column, const uint32_t *rows, const int32_t *values, const size_t count);
+
+    /**
+     * @brief Sets 32-bit unsigned values of many rows at once.
+     *
+     * The values are written in one pass under a single lock, so readers see
+     * all of them or none.
+     *
+     * @param column Column handle of a Counter32, Gauge32, TimeTicks, IPAddress
+     * or Counter64 column.
+     * @param rows Row handles.
+     * @param values Values, by position in rows.
+     * @param count Count of rows and values.
+     * @return true if success, false if the column, the type or any row is
+     * invalid, in which case nothing is written.
+     */
+    bool setUnsigned(const uint32_t column, const uint32_t *rows, const uint32_t *values, const size_t count);
+
+    /**
+     * @brief Sets 64-bit unsigned values of many rows at once.
+     *
+     * @param column Column handle of a Counter32, Gauge32, TimeTicks, IPAddress
+     * or Counter64 column.
+     * @param rows Row handles.
+     * @param values Values, by position in rows, truncated to 32 bits except
+     * for Counter64.
+     * @param count Count of rows and values.
+     * @return true if success, false if the column, the type or any row is
+     * invalid, in which case nothing is written.
+     */
+    bool setUnsigned(const uint32_t column, const uint32_t *rows, const uint64_t *values, const size_t count);
+
+    virtual BER* get(const ObjectIdentifier &oid);
+    virtual bool next(const ObjectIdentifier &oid, ObjectIdentifier &next);
+    virtual size_t walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances);
+
+protected:
+    /**
+     * @struct Column
+     * @brief Column values, by row slot.
+     */
+    struct Column {
+        /** Column arc. */
+        uint32_t _arc;
+        /** Column BER type. */
+        uint8_t _type;
+        /** Values of 32-bit columns. */
+        std::vector<uint32_t> _values32;
+        /** Values of 64-bit columns. */
+        std::vector<uint64_t> _values64;
+        /** Values of OctetString columns. */
+        std::vector<std::string> _strings;
+    };
+
+    /** Entry %OID. */
+    ObjectIdentifier _entry;
+    /** Columns, by handle. */
+    std::vector<Column> _columns;
+    /** Column handles sorted by arc. */
+    std::vector<uint32_t> _sorted;
+    /** Row indexes, by slot. Empty for a free slot. */
+    std::vector<ObjectIdentifier> _indexes;
+    /** Used slots sorted by index. */
+    std::vector<uint32_t> _order;
+    /** Free slots. */
+    std::vector<uint32_t> _free;
+    /** Readers share the lock, writers own it. */
+    mutable std::shared_mutex _mutex;
+
+    /**
+     * @brief Creates the value of a cell.
+     *
+     * @param column Column.
+     * @param row Row slot.
+     * @return New BER value.
+     */
+    static BER* value(const Column &column, const uint32_t row);
+
+    /**
+     * @brief Checks if a row and a column handles are valid.
+     *
+     * @param row Row handle.
+     * @param column Column handle.
+     * @return true if valid.
+     */
+    bool valid(const uint32_t row, const uint32_t column) const {
+        return (row < _indexes.size()) && !_indexes[row].empty() && (column < _columns.size());
+    }
+
+    /**
+     * @brief Checks that row handles are valid.
+     *
+     * @param rows Row handles.
+     * @param count Count of rows.
+     * @return true if all valid.
+     */
+    bool valid(const uint32_t *rows, const size_t count) const;
+
+    /**
+     * @brief Finds the position in the index order of the first row after an
+     * index.
+     *
+     * @param index Pointer to the index arcs.
+     * @param size Count of index arcs.
+     * @param inclusive true to include a row with this exact index.
+     * @return Position in the index order.
+     */
+    size_t position(const uint32_t *index, const size_t size, const bool inclusive) const;
+
+    /**
+     * @brief Finds the column and row of the first instance after an %OID.
+     *
+     * @param oid %OID to start from.
+     * @param column Position of the column in the arc order, may be the count
+     * of columns.
+     * @param row Position of the row in the index order, may be the count of
+     * rows.
+     * @return false if the %OID is after the table.
+     */
+    bool locate(const ObjectIdentifier &oid, size_t &column, size_t &row) const;
+
+    /**
+     * @brief Walks without locking.
+     *
+     * @param oid %OID to start from.
+     * @param count Maximum count of instances.
+     * @param instances Instances, appended in order.
+     * @return Count of appended instances.
+     */
+    size_t scan(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances) const;
+};
+
+} // namespace SNMP
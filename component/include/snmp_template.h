@@ -0,0 +1,217 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "ber.h"
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+#if !SNMP_STREAM
+/**
+ * @class ResponseTemplate
+ * @brief Pre-encoded message with a fixed variable bindings layout.
+ *
+ * When the same OIDs are polled again and again, building a Message tree for
+ * each response is wasted work: only the request identifier and a few values
+ * change. A template encodes the message once and records the offset and the
+ * width of the request identifier, the error fields and each value. Setting a
+ * field then overwrites its bytes in place.
+ *
+ * Lengths are re-encoded only when the encoded width of a field changes, e.g.
+ * a counter growing from 0xFFFF to 0x10000. The message is then laid out again
+ * in a second buffer, both buffers being reused.
+ *
+ * The encoded message is always valid and can be sent as is.
+ *
+ * @note Available only when SNMP_STREAM is 0.
+ *
+ * Example
+ *
+ * ```cpp
+ * ResponseTemplate response(Version::V2C, "public");
+ * uint32_t inOctets = response.add("1.3.6.1.2.1.2.2.1.10.1", new Counter32BER(0));
+ * uint32_t outOctets = response.add("1.3.6.1.2.1.2.2.1.16.1", new Counter32BER(0));
+ *
+ * // On each request
+ * response.setRequestID(request->getRequestID());
+ * response.setUnsigned(inOctets, Type::Counter32, in);
+ * response.setUnsigned(outOctets, Type::Counter32, out);
+ * agent->send(response.data(), response.size(), remote, port);
+ * ```
+ */
+class ResponseTemplate {
+public:
+    /**
+     * @brief Creates an empty template.
+     *
+     * @param version %SNMP version.
+     * @param community %SNMP community.
+     * @param type PDU BER type.
+     */
+    ResponseTemplate(const uint8_t version, const char *community,
+            const uint8_t type = Type::GetResponse);
+
+    /**
+     * @brief Adds a variable binding.
+     *
+     * @param oid %OID of the variable binding.
+     * @param value Initial value, released once encoded. nullptr for NULL.
+     * @return Index of the variable binding.
+     */
+    uint32_t add(const char *oid, BER *value = nullptr);
+
+    /**
+     * @brief Sets the request identifier.
+     *
+     * @param requestID Request identifier.
+     */
+    void setRequestID(const int32_t requestID);
+
+    /**
+     * @brief Sets error status and error index.
+     *
+     * @param status Error status.
+     * @param index Error index.
+     */
+    void setError(const uint8_t status, const uint32_t index);
+
+    /**
+     * @brief Sets a value.
+     *
+     * @param index Index of the variable binding.
+     * @param value New value, released once encoded.
+     * @return true if success, false if the index is invalid.
+     */
+    bool setValue(const uint32_t index, BER *value);
+
+    /**
+     * @brief Sets an INTEGER value.
+     *
+     * @param index Index of the variable binding.
+     * @param value New value.
+     * @return true if success, false if the index is invalid.
+     */
+    bool setInteger(const uint32_t index, const int32_t value);
+
+    /**
+     * @brief Sets an unsigned value.
+     *
+     * @param index Index of the variable binding.
+     * @param type Value type: Counter32, Gauge32, TimeTicks or Counter64.
+     * @param value New value.
+     * @return true if success, false if the index is invalid.
+     */
+    bool setUnsigned(const uint32_t index, const uint8_t type, const uint64_t value);
+
+    /**
+     * @brief Sets an OCTET STRING value.
+     *
+     * @param index Index of the variable binding.
+     * @param value New value.
+     * @param length Length of the value.
+     * @return true if success, false if the index is invalid.
+     */
+    bool setOctetString(const uint32_t index, const char *value, const size_t length);
+
+    /**
+     * @brief Gets the encoded message.
+     *
+     * @return Pointer to the encoded message.
+     */
+    const uint8_t* data() const {
+        return _buffer.data();
+    }
+
+    /**
+     * @brief Gets the size of the encoded message.
+     *
+     * @return Size in bytes.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @brief Gets the count of variable bindings.
+     *
+     * @return Count of variable bindings.
+     */
+    uint32_t count() const {
+        return _bindings.size();
+    }
+
+private:
+    /**
+     * @struct Field
+     * @brief Location of an encoded TLV in the buffer.
+     */
+    struct Field {
+        /** Offset from the start of the buffer. */
+        uint32_t _offset;
+        /** Size in bytes. */
+        uint32_t _size;
+    };
+
+    /**
+     * @struct Binding
+     * @brief Location of a variable binding.
+     */
+    struct Binding {
+        /** Encoded OID. */
+        Field _name;
+        /** Encoded value. */
+        Field _value;
+    };
+
+    /** PDU BER type. */
+    uint8_t _type;
+    /** Version and community, encoded. */
+    Field _header;
+    /** Request identifier, encoded. */
+    Field _requestID;
+    /** Error status, encoded. */
+    Field _status;
+    /** Error index, encoded. */
+    Field _index;
+    /** Variable bindings. */
+    std::vector<Binding> _bindings;
+    /** Encoded message, followed by fields waiting for a layout. */
+    std::vector<uint8_t> _buffer;
+    /** Layout buffer, swapped with the message buffer. */
+    std::vector<uint8_t> _layout;
+    /** Size of the encoded message. */
+    size_t _size = 0;
+    /** True if a field is staged. */
+    bool _staged = false;
+
+    /**
+     * @brief Gets room to encode a field.
+     *
+     * If the width is unchanged, the room is the field itself and the field is
+     * overwritten in place. Otherwise the field is staged at the end of the
+     * buffer, to be moved by the next layout.
+     *
+     * @param field Field to encode.
+     * @param size Size of the encoded TLV.
+     * @return Pointer to the room.
+     */
+    uint8_t* prepare(Field &field, const uint32_t size);
+
+    /**
+     * @brief Lays the message out if a field is staged.
+     */
+    void commit();
+
+    /**
+     * @brief Lays the message out with current fields.
+     */
+    void layout();
+};
+#endif
+
+} // namespace SNMP
@@ -0,0 +1,390 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <variant>
+#include <vector>
+#include "ber.h"
+#include "snmp_oid.h"
+
+/**
+ * @namespace SNMP
+ * @brief %SNMP library namespace.
+ */
+namespace SNMP {
+
+#if !SNMP_STREAM
+/**
+ * @class Value
+ * @brief %SNMP value as a tagged variant.
+ *
+ * BER objects are heap nodes encoded and decoded through virtual calls, one per
+ * node, and decoding an array creates each element with BER::create() first.
+ * A Value holds any %SNMP value in place, tagged with its BER type, and its
+ * codec switches on the tag, so the integer and %OID paths are inlined in the
+ * encoding and decoding loops.
+ *
+ * - Integer, Boolean, Counter32, Gauge32, TimeTicks and Counter64 hold an
+ * integer.
+ * - OctetString, IPAddress and Opaque hold bytes. An Opaque embedding a float
+ * is decoded as OpaqueFloat.
+ * - ObjectIdentifier holds an ObjectIdentifier.
+ * - Null, NoSuchObject, NoSuchInstance and EndOfMIBView hold nothing.
+ *
+ * A Value is used in a VarBind through a ValueBER, and bindings are decoded
+ * from an encoded variable bindings list by Value::decode().
+ *
+ * @note Available only when SNMP_STREAM is 0.
+ *
+ * Example
+ *
+ * ```cpp
+ * message.add("1.3.6.1.2.1.1.3.0", new ValueBER(Value::timeTicks(uptime)));
+ * message.add("1.3.6.1.2.1.1.5.0", new ValueBER(Value("router")));
+ *
+ * std::vector<Value::Binding> bindings;
+ * if (Value::decode(data, size, bindings)) {
+ *     uint32_t uptime = bindings[0]._value.getUnsigned();
+ * }
+ * ```
+ */
+class Value {
+public:
+    struct Binding;
+
+    /**
+     * @brief Creates a Null value.
+     */
+    Value() :
+            _type(Type::Null), _data(int64_t(0)) {
+    }
+
+    /**
+     * @brief Creates an Integer value.
+     *
+     * @param value Integer.
+     */
+    Value(const int32_t value) :
+            _type(Type::Integer), _data(int64_t(value)) {
+    }
+
+    /**
+     * @brief Creates an OctetString value.
+     *
+     * @param value Null-terminated string.
+     */
+    Value(const char *value) :
+            _type(Type::OctetString), _data(std::string(value ? value : "")) {
+    }
+
+    /**
+     * @brief Creates an OctetString value.
+     *
+     * @param value Bytes.
+     * @param length Count of bytes.
+     */
+    Value(const char *value, const size_t length) :
+            _type(Type::OctetString), _data(std::string(value, length)) {
+    }
+
+    /**
+     * @brief Creates an ObjectIdentifier value.
+     *
+     * @param value %OID.
+     */
+    Value(const ObjectIdentifier &value) :
+            _type(Type::ObjectIdentifier), _data(value) {
+    }
+
+    /**
+     * @brief Creates an IPAddress value.
+     *
+     * @param value IPv4 address.
+     */
+    Value(const IPAddress &value);
+
+    /**
+     * @brief Creates an OpaqueFloat value.
+     *
+     * @param value Float.
+     */
+    Value(const float value) :
+            _type(Type::OpaqueFloat), _data(value) {
+    }
+
+    /**
+     * @brief Creates a Null or exception value.
+     *
+     * @param type Null, NoSuchObject, NoSuchInstance or EndOfMIBView.
+     * @return Value.
+     */
+    static Value null(const uint16_t type = Type::Null) {
+        return Value(type, int64_t(0));
+    }
+
+    /**
+     * @brief Creates a Boolean value.
+     *
+     * @param value Boolean.
+     * @return Value.
+     */
+    static Value boolean(const bool value) {
+        return Value(Type::Boolean, int64_t(value));
+    }
+
+    /**
+     * @brief Creates a Counter32 value.
+     *
+     * @param value Counter.
+     * @return Value.
+     */
+    static Value counter32(const uint32_t value) {
+        return Value(Type::Counter32, int64_t(value));
+    }
+
+    /**
+     * @brief Creates a Gauge32 value.
+     *
+     * @param value Gauge.
+     * @return Value.
+     */
+    static Value gauge32(const uint32_t value) {
+        return Value(Type::Gauge32, int64_t(value));
+    }
+
+    /**
+     * @brief Creates a TimeTicks value.
+     *
+     * @param value Hundredths of second.
+     * @return Value.
+     */
+    static Value timeTicks(const uint32_t value) {
+        return Value(Type::TimeTicks, int64_t(value));
+    }
+
+    /**
+     * @brief Creates a Counter64 value.
+     *
+     * @param value Counter.
+     * @return Value.
+     */
+    static Value counter64(const uint64_t value) {
+        return Value(Type::Counter64, int64_t(value));
+    }
+
+    /**
+     * @brief Creates an Opaque value.
+     *
+     * @param value Encoded content.
+     * @param length Count of bytes.
+     * @return Value.
+     */
+    static Value opaque(const uint8_t *value, const size_t length) {
+        return Value(Type::Opaque, std::string(reinterpret_cast<const char*>(value), length));
+    }
+
+    /**
+     * @brief Creates a value from a BER object.
+     *
+     * The BER is encoded then decoded, for values of received messages.
+     *
+     * @param ber BER object.
+     * @return Value, Null if the BER can't be decoded as a value.
+     */
+    static Value from(BER *ber);
+
+    /**
+     * @brief Gets the BER type.
+     *
+     * @return BER type, Type::OpaqueFloat for a float.
+     */
+    uint16_t getType() const {
+        return _type;
+    }
+
+    /**
+     * @brief Gets a signed integer.
+     *
+     * @return Integer value, 0 if not an integer type.
+     */
+    int32_t getInteger() const {
+        const int64_t *value = std::get_if<int64_t>(&_data);
+        return value ? *value : 0;
+    }
+
+    /**
+     * @brief Gets an unsigned integer, Counter32, Gauge32, TimeTicks or
+     * Counter64.
+     *
+     * @return Unsigned value, 0 if not an integer type.
+     */
+    uint64_t getUnsigned() const {
+        const int64_t *value = std::get_if<int64_t>(&_data);
+        return value ? *value : 0;
+    }
+
+    /**
+     * @brief Gets a float.
+     *
+     * @return Float value, 0 if not an OpaqueFloat.
+     */
+    float getFloat() const {
+        const float *value = std::get_if<float>(&_data);
+        return value ? *value : 0;
+    }
+
+    /**
+     * @brief Gets the bytes of an OctetString, IPAddress or Opaque.
+     *
+     * @return Bytes, empty if not a bytes type.
+     */
+    const std::string& getBytes() const;
+
+    /**
+     * @brief Gets an %OID.
+     *
+     * @return %OID, empty if not an ObjectIdentifier.
+     */
+    const ObjectIdentifier& getOID() const;
+
+    /**
+     * @brief Gets the size of the encoded value.
+     *
+     * @return Size, type, length and content.
+     */
+    unsigned int getSize() const;
+
+    /**
+     * @brief Encodes the value.
+     *
+     * @param buffer Pointer to the buffer, at least getSize() bytes.
+     * @return Next position to be written in buffer.
+     */
+    uint8_t* encode(uint8_t *buffer) const;
+
+    /**
+     * @brief Decodes a value.
+     *
+     * @param pointer Position to read, advanced past the value.
+     * @param end End of the buffer.
+     * @return true if success, false if malformed or of an unknown type.
+     */
+    bool decode(const uint8_t *&pointer, const uint8_t *end);
+
+    /**
+     * @brief Gets the size of an encoded variable bindings list.
+     *
+     * @param bindings Variable bindings.
+     * @return Size of the list.
+     */
+    static unsigned int getSize(const std::vector<Binding> &bindings);
+
+    /**
+     * @brief Encodes a variable bindings list.
+     *
+     * @param bindings Variable bindings.
+     * @param buffer Pointer to the buffer, at least getSize(bindings) bytes.
+     * @return Next position to be written in buffer.
+     */
+    static uint8_t* encode(const std::vector<Binding> &bindings, uint8_t *buffer);
+
+    /**
+     * @brief Decodes a variable bindings list.
+     *
+     * @param data Encoded list, a SEQUENCE of variable bindings.
+     * @param size Size of the encoded list.
+     * @param bindings Decoded bindings are appended.
+     * @return true if success, false if malformed. The bindings decoded before
+     * the error are kept.
+     */
+    static bool decode(const uint8_t *data, const size_t size, std::vector<Binding> &bindings);
+
+    bool operator==(const Value &other) const = default;
+
+private:
+    /** BER type. */
+    uint16_t _type;
+    /** Integer, float, bytes or %OID, depending on the type. */
+    std::variant<int64_t, float, std::string, ObjectIdentifier> _data;
+
+    /**
+     * @brief Creates a value of a type.
+     *
+     * @param type BER type.
+     * @param data Content.
+     */
+    template<typename T>
+    Value(const uint16_t type, T &&data) :
+            _type(type), _data(std::forward<T>(data)) {
+    }
+};
+
+/**
+ * @struct Value::Binding
+ * @brief Variable binding of a Value.
+ */
+struct Value::Binding {
+    /** Name. */
+    ObjectIdentifier _oid;
+    /** Value. */
+    Value _value;
+};
+
+/**
+ * @class ValueBER
+ * @brief BER object encoding a Value.
+ *
+ * Lets a Value be used where a BER is expected, e.g. in a VarBind or returned
+ * by a Provider. The value is encoded by the Value codec.
+ *
+ * @note ValueBER is write only, it is never created by decoding.
+ */
+class ValueBER: public BER {
+public:
+    /**
+     * @brief Creates a ValueBER object.
+     *
+     * @param value Value.
+     */
+    ValueBER(Value value) :
+            BER(value.getType() == Type::OpaqueFloat ? static_cast<uint8_t>(Type::Opaque)
+                    : static_cast<uint8_t>(value.getType())), _value(std::move(value)) {
+    }
+
+    /**
+     * @brief Encodes the value to buffer.
+     *
+     * @param buffer Pointer to the buffer.
+     * @return Next position to be written in buffer.
+     */
+    virtual uint8_t* encode(uint8_t *buffer) {
+        return _value.encode(buffer);
+    }
+
+    /**
+     * @brief Gets the size of the encoded value.
+     *
+     * @return Size of the encoded value.
+     */
+    virtual unsigned int getSize(const bool /* refresh */ = false) {
+        _size = _value.getSize();
+        return _size;
+    }
+
+    /**
+     * @brief Gets the value.
+     *
+     * @return Value.
+     */
+    const Value& getValue() const {
+        return _value;
+    }
+
+private:
+    /** Value. */
+    Value _value;
+};
+#endif
+
+} // namespace SNMP
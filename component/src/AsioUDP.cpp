@@ -1,12 +1,40 @@
 // AsioUDP.cpp - ASIO-based implementation of UDP for SNMP-ASIO library
 #include "AsioUDP.h"
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+
+namespace {
+
+// Convert an IPAddress to an ASIO address
+asio::ip::address toAddress(const IPAddress& ip) {
+    if (ip.isV6()) {
+        asio::ip::address_v6::bytes_type bytes;
+        std::copy(ip.raw_address(), ip.raw_address() + bytes.size(), bytes.begin());
+        return asio::ip::address_v6(bytes);
+    }
+    return asio::ip::address_v4(static_cast<uint32_t>(ip));
+}
+
+// Convert an ASIO address to an IPAddress, unmapping IPv4-mapped IPv6 addresses
+IPAddress toIPAddress(const asio::ip::address& address) {
+    if (address.is_v6()) {
+        asio::ip::address_v6 v6 = address.to_v6();
+        if (!v6.is_v4_mapped()) {
+            return IPAddress(IPv6, v6.to_bytes().data());
+        }
+        return IPAddress(asio::ip::make_address_v4(asio::ip::v4_mapped, v6).to_uint());
+    }
+    return IPAddress(address.to_v4().to_uint());
+}
+
+} // namespace
 
 // Constructor
 AsioUDP::AsioUDP(asio::io_context& io_context)
     : io_context_(io_context),
       socket_(io_context),
-      rx_buffer_(1500), // Default MTU size
+      rx_buffer_(65535), // Largest UDP payload, async_receive_from truncates longer datagrams
       tx_buffer_(1500)  // Default MTU size
 {
 }
@@ -16,27 +44,47 @@ AsioUDP::~AsioUDP() {
     stop();
 }
 
-// Begin listening on specified port
-uint8_t AsioUDP::begin(uint16_t port) {
+// Open the socket for the family of the address
+bool AsioUDP::open(const IPAddress& address) {
     // Close socket if already open
     asio::error_code ec;
     if (socket_.is_open()) {
         socket_.close(ec);
         if (ec) {
-            return 0; // Failure
+            return false;
         }
     }
     
-    // Open and bind the socket
-    socket_.open(asio::ip::udp::v4(), ec);
+    v6_socket_ = false;
+    socket_.open(address.isV6() ? asio::ip::udp::v6() : asio::ip::udp::v4(), ec);
+    if (!ec && address.isV6()) {
+        // Dual-stack unless restricted, IPv4 peers then appear as IPv4-mapped addresses
+        socket_.set_option(asio::ip::v6_only(v6_only_), ec);
+    }
     if (ec) {
         if (error_callback_) {
             error_callback_(ec);
         }
+        return false;
+    }
+    v6_socket_ = address.isV6();
+    return true;
+}
+
+// Begin listening on specified port
+uint8_t AsioUDP::begin(uint16_t port) {
+    return begin(IPAddress(IPv4), port);
+}
+
+// Begin listening on specified address and port
+uint8_t AsioUDP::begin(const IPAddress& address, uint16_t port) {
+    // Open and bind the socket
+    if (!open(address)) {
         return 0; // Failure
     }
     
-    socket_.bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), port), ec);
+    asio::error_code ec;
+    socket_.bind(asio::ip::udp::endpoint(toAddress(address), port), ec);
     if (ec) {
         if (error_callback_) {
             error_callback_(ec);
@@ -54,24 +102,12 @@ uint8_t AsioUDP::begin(uint16_t port) {
 
 // Begin multicast listening
 uint8_t AsioUDP::beginMulticast(const IPAddress& addr, uint16_t port) {
-    // Close socket if already open
-    asio::error_code ec;
-    if (socket_.is_open()) {
-        socket_.close(ec);
-        if (ec) {
-            return 0; // Failure
-        }
-    }
-    
     // Open and bind the socket
-    socket_.open(asio::ip::udp::v4(), ec);
-    if (ec) {
-        if (error_callback_) {
-            error_callback_(ec);
-        }
+    if (!open(addr)) {
         return 0; // Failure
     }
     
+    asio::error_code ec;
     socket_.set_option(asio::ip::udp::socket::reuse_address(true), ec);
     if (ec) {
         if (error_callback_) {
@@ -80,7 +116,7 @@ uint8_t AsioUDP::beginMulticast(const IPAddress& addr, uint16_t port) {
         return 0; // Failure
     }
     
-    socket_.bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), port), ec);
+    socket_.bind(asio::ip::udp::endpoint(addr.isV6() ? asio::ip::udp::v6() : asio::ip::udp::v4(), port), ec);
     if (ec) {
         if (error_callback_) {
             error_callback_(ec);
@@ -89,8 +125,7 @@ uint8_t AsioUDP::beginMulticast(const IPAddress& addr, uint16_t port) {
     }
     
     // Join multicast group
-    asio::ip::address_v4 multicast_addr(static_cast<uint32_t>(addr));
-    socket_.set_option(asio::ip::multicast::join_group(multicast_addr), ec);
+    socket_.set_option(asio::ip::multicast::join_group(toAddress(addr)), ec);
     if (ec) {
         if (error_callback_) {
             error_callback_(ec);
@@ -119,11 +154,13 @@ void AsioUDP::stop() {
 
 // Begin packet to IP address
 int AsioUDP::beginPacket(const IPAddress& ip, uint16_t port) {
-    tx_endpoint_ = asio::ip::udp::endpoint(
-        asio::ip::address_v4(static_cast<uint32_t>(ip)),
-        port
-    );
-    tx_buffer_.clear();
+    asio::ip::address address = toAddress(ip);
+    if (address.is_v4() && v6_socket_ && socket_.is_open()) {
+        // Reach IPv4 peers through the dual-stack socket
+        address = asio::ip::make_address_v6(asio::ip::v4_mapped, address.to_v4());
+    }
+    tx_endpoint_ = asio::ip::udp::endpoint(address, port);
+    tx_length_ = 0;
     return 1; // Success
 }
 
@@ -140,7 +177,7 @@ int AsioUDP::beginPacket(const char* host, uint16_t port) {
     }
     
     tx_endpoint_ = *endpoints.begin();
-    tx_buffer_.clear();
+    tx_length_ = 0;
     return 1; // Success
 }
 
@@ -153,7 +190,7 @@ int AsioUDP::endPacket() {
     // Send the packet
     asio::error_code ec;
     auto bytes_sent = socket_.send_to(
-        asio::buffer(tx_buffer_.data(), tx_buffer_.size()),
+        asio::buffer(tx_buffer_.data(), tx_length_),
         tx_endpoint_,
         0, // flags
         ec
@@ -166,7 +203,7 @@ int AsioUDP::endPacket() {
         return 0; // Failure
     }
     
-    return (bytes_sent == tx_buffer_.size()) ? 1 : 0;
+    return (bytes_sent == tx_length_) ? 1 : 0;
 }
 
 // Parse next available packet - still available for backward compatibility
@@ -177,7 +214,7 @@ int AsioUDP::parsePacket() {
 
 // Get remote IP address
 IPAddress AsioUDP::remoteIP() {
-    return IPAddress(remote_endpoint_.address().to_v4().to_uint());
+    return toIPAddress(remote_endpoint_.address());
 }
 
 // Get remote port
@@ -210,16 +247,31 @@ int AsioUDP::peek() {
 
 // Stream implementation - write single byte
 size_t AsioUDP::write(uint8_t byte) {
-    tx_buffer_.push_back(byte);
+    *prepare(1) = byte;
+    commit(1);
     return 1;
 }
 
 // Stream implementation - write buffer
 size_t AsioUDP::write(const uint8_t* buffer, size_t size) {
-    tx_buffer_.insert(tx_buffer_.end(), buffer, buffer + size);
+    memcpy(prepare(size), buffer, size);
+    commit(size);
     return size;
 }
 
+// Get room for size bytes at the end of the packet, growing the buffer if needed
+uint8_t* AsioUDP::prepare(size_t size) {
+    if (tx_length_ + size > tx_buffer_.size()) {
+        tx_buffer_.resize(std::max(tx_length_ + size, tx_buffer_.size() * 2));
+    }
+    return tx_buffer_.data() + tx_length_;
+}
+
+// Append bytes written to the room given by prepare()
+void AsioUDP::commit(size_t size) {
+    tx_length_ += size;
+}
+
 // Stream implementation - flush
 void AsioUDP::flush() {
     // Nothing to do for UDP
@@ -244,6 +296,11 @@ void AsioUDP::setPacketCallback(PacketReceivedCallback callback) {
     }
 }
 
+// Restrict IPv6 sockets to IPv6 peers, applied when the socket is opened
+void AsioUDP::setV6Only(bool v6_only) {
+    v6_only_ = v6_only;
+}
+
 // Set callback for error handling
 void AsioUDP::setErrorCallback(ErrorCallback callback) {
     error_callback_ = callback;
@@ -297,7 +354,7 @@ void AsioUDP::handleReceive(const asio::error_code& error, size_t bytes_transfer
             packet_callback_(
                 rx_buffer_.data(),
                 bytes_transferred,
-                IPAddress(remote_endpoint_.address().to_v4().to_uint()),
+                toIPAddress(remote_endpoint_.address()),
                 remote_endpoint_.port()
             );
         }
@@ -1,5 +1,8 @@
 #include "arduino_compat/IPAddress.h"
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
 
 #if defined(_MSC_VER)
     // MSVC-specific secure functions
@@ -10,14 +13,24 @@
 #endif
 
 // Default constructor
-IPAddress::IPAddress() : bytes{0, 0, 0, 0} {}
+IPAddress::IPAddress() : bytes{}, family(IPv4) {}
+
+// Constructor of the unspecified address of a family
+IPAddress::IPAddress(IPType type) : bytes{}, family(type) {}
+
+// Constructor from raw bytes of a family
+IPAddress::IPAddress(IPType type, const uint8_t* address) : bytes{}, family(type) {
+    if (address) {
+        memcpy(bytes.data(), address, size());
+    }
+}
 
 // Constructor from 4 octets
 IPAddress::IPAddress(uint8_t first_octet, uint8_t second_octet, uint8_t third_octet, uint8_t fourth_octet) 
-    : bytes{first_octet, second_octet, third_octet, fourth_octet} {}
+    : bytes{first_octet, second_octet, third_octet, fourth_octet}, family(IPv4) {}
 
 // Constructor from uint32_t
-IPAddress::IPAddress(uint32_t address) {
+IPAddress::IPAddress(uint32_t address) : bytes{}, family(IPv4) {
     bytes[0] = (address >> 24) & 0xFF;
     bytes[1] = (address >> 16) & 0xFF;
     bytes[2] = (address >> 8) & 0xFF;
@@ -25,17 +38,17 @@ IPAddress::IPAddress(uint32_t address) {
 }
 
 // Constructor from string
-IPAddress::IPAddress(const char* address) {
+IPAddress::IPAddress(const char* address) : bytes{}, family(IPv4) {
     fromString(address);
 }
 
 // Constructor from std::string
-IPAddress::IPAddress(const std::string& address) {
+IPAddress::IPAddress(const std::string& address) : bytes{}, family(IPv4) {
     fromString(address.c_str());
 }
 
 // Constructor from raw byte array
-IPAddress::IPAddress(const uint8_t* address) {
+IPAddress::IPAddress(const uint8_t* address) : bytes{}, family(IPv4) {
     if (address) {
         bytes[0] = address[0];
         bytes[1] = address[1];
@@ -46,6 +59,8 @@ IPAddress::IPAddress(const uint8_t* address) {
 
 // Assignment operator for uint32_t
 IPAddress& IPAddress::operator=(uint32_t address) {
+    bytes = {};
+    family = IPv4;
     bytes[0] = (address >> 24) & 0xFF;
     bytes[1] = (address >> 16) & 0xFF;
     bytes[2] = (address >> 8) & 0xFF;
@@ -56,6 +71,8 @@ IPAddress& IPAddress::operator=(uint32_t address) {
 // Assignment operator for raw byte array
 IPAddress& IPAddress::operator=(const uint8_t* address) {
     if (address) {
+        bytes = {};
+        family = IPv4;
         bytes[0] = address[0];
         bytes[1] = address[1];
         bytes[2] = address[2];
@@ -66,12 +83,15 @@ IPAddress& IPAddress::operator=(const uint8_t* address) {
 
 // Convert to uint32_t
 IPAddress::operator uint32_t() const {
+    if (family == IPv6) {
+        return 0;
+    }
     return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
 }
 
 // Check if address is set
 bool IPAddress::isSet() const {
-    return *this != IPAddress();
+    return bytes != std::array<uint8_t, 16>{};
 }
 
 // Boolean conversion
@@ -81,7 +101,7 @@ IPAddress::operator bool() const {
 
 // Access individual octets
 uint8_t IPAddress::operator[](int index) const {
-    if (index >= 0 && index < 4) {
+    if (index >= 0 && index < size()) {
         return bytes[index];
     }
     return 0;
@@ -93,23 +113,56 @@ uint8_t& IPAddress::operator[](int index) {
 
 // Equality operators
 bool IPAddress::operator==(const IPAddress& addr) const {
-    return bytes == addr.bytes;
+    return family == addr.family && bytes == addr.bytes;
 }
 
 bool IPAddress::operator!=(const IPAddress& addr) const {
-    return bytes != addr.bytes;
+    return !(*this == addr);
 }
 
 bool IPAddress::operator==(uint32_t addr) const {
-    return static_cast<uint32_t>(*this) == addr;
+    return family == IPv4 && static_cast<uint32_t>(*this) == addr;
 }
 
 bool IPAddress::operator!=(uint32_t addr) const {
-    return static_cast<uint32_t>(*this) != addr;
+    return !(*this == addr);
 }
 
 // Convert to string
 std::string IPAddress::toString() const {
+    if (family == IPv6) {
+        // RFC 5952: compress the longest run of at least 2 zero groups
+        uint16_t groups[8];
+        for (int index = 0; index < 8; ++index) {
+            groups[index] = (bytes[index * 2] << 8) | bytes[index * 2 + 1];
+        }
+        int start = -1, length = 0;
+        for (int index = 0; index < 8;) {
+            int end = index;
+            while (end < 8 && groups[end] == 0) {
+                end++;
+            }
+            if (end - index > length && end - index > 1) {
+                start = index;
+                length = end - index;
+            }
+            index = end > index ? end : index + 1;
+        }
+        std::stringstream ss;
+        ss << std::hex;
+        for (int index = 0; index < 8; ++index) {
+            if (index == start) {
+                ss << "::";
+                index += length - 1;
+                continue;
+            }
+            if (index && index != start + length) {
+                ss << ":";
+            }
+            ss << groups[index];
+        }
+        return ss.str();
+    }
     std::stringstream ss;
     ss << static_cast<int>(bytes[0]) << "." 
        << static_cast<int>(bytes[1]) << "." 
@@ -120,16 +173,87 @@ std::string IPAddress::toString() const {
 
 // Parse from string
 bool IPAddress::fromString(const char* address) {
+    if (!address) {
+        return false;
+    }
     unsigned int a, b, c, d;
     int result = SSCANF(address, "%u.%u.%u.%u", &a, &b, &c, &d);
     if (result == 4 && a < 256 && b < 256 && c < 256 && d < 256) {
+        bytes = {};
+        family = IPv4;
         bytes[0] = a;
         bytes[1] = b;
         bytes[2] = c;
         bytes[3] = d;
         return true;
     }
-    return false;
+    return fromString6(address);
+}
+
+// Parse IPv6 text form, with optional "::" and embedded IPv4 tail
+bool IPAddress::fromString6(const char* address) {
+    uint16_t groups[8];
+    int count = 0;
+    int gap = -1;
+    const char* pointer = address;
+    if (pointer[0] == ':') {
+        if (pointer[1] != ':') {
+            return false;
+        }
+        gap = 0;
+        pointer += 2;
+    }
+    while (*pointer) {
+        if (count == 8) {
+            return false;
+        }
+        const char* end = pointer;
+        while (isxdigit(static_cast<unsigned char>(*end))) {
+            end++;
+        }
+        if (*end == '.') {
+            // Embedded IPv4 address ends the text form
+            unsigned int a, b, c, d;
+            if (count > 6 || SSCANF(pointer, "%u.%u.%u.%u", &a, &b, &c, &d) != 4
+                    || a > 255 || b > 255 || c > 255 || d > 255) {
+                return false;
+            }
+            groups[count++] = (a << 8) | b;
+            groups[count++] = (c << 8) | d;
+            break;
+        }
+        if (end == pointer || end - pointer > 4) {
+            return false;
+        }
+        groups[count++] = static_cast<uint16_t>(strtoul(pointer, nullptr, 16));
+        pointer = end;
+        if (*pointer == ':') {
+            pointer++;
+            if (*pointer == ':') {
+                if (gap >= 0) {
+                    return false;
+                }
+                gap = count;
+                pointer++;
+            } else if (!*pointer) {
+                return false;
+            }
+        } else if (*pointer) {
+            return false;
+        }
+    }
+    if (gap < 0 ? count != 8 : count > 7) {
+        return false;
+    }
+    bytes = {};
+    family = IPv6;
+    int tail = gap < 0 ? 0 : count - gap;
+    for (int index = 0; index < count; ++index) {
+        int position = (gap >= 0 && index >= gap) ? 8 - tail + (index - gap) : index;
+        bytes[position * 2] = groups[index] >> 8;
+        bytes[position * 2 + 1] = groups[index] & 0xFF;
+    }
+    return true;
 }
 
 bool IPAddress::fromString(const std::string& address) {
@@ -148,7 +272,7 @@ bool IPAddress::isValid(const std::string& address) {
 
 // Clear the address
 void IPAddress::clear() {
-    bytes = {0, 0, 0, 0};
+    bytes = {};
 }
 
 // Standard pre-defined IP addresses
@@ -64,7 +64,7 @@ BER* BER::create(const Type &type) {
  * Creates an OctetStringBER object from a pointer to an array of char and the
  * array length.
  *
- * The constructor allocates a char array and copies the value parameter.
+ * The constructor copies the value parameter.
  *
  * @param value OctetStringBER char pointer value.
  * @param length Value length.
@@ -15,13 +15,14 @@ SNMP::~SNMP() {
 }
 
 // Initialize network
-bool SNMP::initialize(const IPAddress& bindAddress, uint16_t port) {
+bool SNMP::initialize(const IPAddress& bindAddress, uint16_t port, bool v6Only) {
     if (port == 0) {
         port = _defaultPort;
     }
     
     // Create UDP interface
     _udp = std::make_shared<AsioUDP>(_io_context);
+    _udp->setV6Only(v6Only);
     
     // Set packet handler
     _udp->setPacketCallback(
@@ -40,7 +41,7 @@ bool SNMP::initialize(const IPAddress& bindAddress, uint16_t port) {
     );
     
     // Bind to address and port
-    return _udp->begin(port);
+    return _udp->begin(bindAddress, port);
 }
 
 // Start asynchronous operation
@@ -72,11 +73,13 @@ bool SNMP::send(Message* message, const IPAddress ip, const uint16_t port) {
     message->build(*_udp);
     return _udp->endPacket();
 #else
+    // Encode directly into the transmit buffer of the socket
     uint32_t length = message->getSize(true);
-    std::vector<uint8_t> buffer(length);
-    message->build(buffer.data());
-    _udp->beginPacket(ip, port);
-    _udp->write(buffer.data(), length);
+    if (!_udp->beginPacket(ip, port)) {
+        return false;
+    }
+    message->build(_udp->prepare(length));
+    _udp->commit(length);
     return _udp->endPacket();
 #endif
 }
@@ -86,11 +89,25 @@ bool SNMP::send(std::unique_ptr<Message> message, const IPAddress ip, const uint
     return send(message.get(), ip, port);
 }
 
+// Send an encoded SNMP message
+bool SNMP::send(const uint8_t *data, const size_t length, const IPAddress ip, const uint16_t port) {
+    if (!_udp || !_udp->beginPacket(ip, port)) {
+        return false;
+    }
+    _udp->write(data, length);
+    return _udp->endPacket();
+}
+
 // Set message handler
 void SNMP::onMessage(MessageHandler handler) {
     _onMessage = handler;
 }
 
+// Set request handler
+void SNMP::onRequest(RequestHandler handler) {
+    _onRequest = handler;
+}
+
 // Set error handler
 void SNMP::onError(ErrorHandler handler) {
     _onError = handler;
@@ -98,32 +115,81 @@ void SNMP::onError(ErrorHandler handler) {
 
 // Handle received packet
 void SNMP::handlePacket(const uint8_t* data, size_t length, const IPAddress& remote, uint16_t port) {
+    // Drop packets from sources exceeding their rate
+    if (!_rateLimiter.allow(remote)) {
+        return;
+    }
+    
+    // Drop unwanted packets before the full decode
+    if (_filter.check(data, length, remote) != Filter::Verdict::Accept) {
+        return;
+    }
+    
     // Parse as SNMP message
-    Message* message = new Message();
+    auto message = std::make_unique<Message>();
     
-    // Copy data to writable buffer (as parse takes a non-const buffer)
+    // Copy data, kept by the message to decode values on access
     std::vector<uint8_t> buffer(data, data + length);
     
 #if SNMP_STREAM
     // SNMP_STREAM is not supported in this context
-    delete message;
     if (_onError) {
         _onError(asio::error::operation_not_supported);
     }
     return;
 #else
-    // Parse from buffer
-    message->parse(buffer.data());
+    // Index the variable bindings, values are decoded on access
+    if (!message->index(buffer)) {
+        return;
+    }
+    
+    // Hand the message over to a deferred request if a request handler is set
+    if (_onRequest) {
+        _onRequest(std::make_shared<Request>(weak_from_this(), std::move(message), remote, port));
+        return;
+    }
     
     // Call user handler if set
     if (_onMessage) {
-        _onMessage(message, remote, port);
+        _onMessage(message.get(), remote, port);
     }
-    
-    delete message;
 #endif
 }
 
+// Request constructor
+Request::Request(std::weak_ptr<SNMP> snmp, std::unique_ptr<Message> message, const IPAddress &remote,
+        const uint16_t port)
+    : _snmp(snmp), _message(std::move(message)), _remote(remote), _port(port), _completed(false)
+{
+}
+
+// Create an empty response
+std::unique_ptr<Message> Request::createResponse() const {
+    auto response = std::make_unique<Message>(_message->getVersion(), _message->getCommunity(), Type::GetResponse);
+    response->setRequestID(_message->getRequestID());
+    return response;
+}
+
+// Respond to the sender from the io_context
+bool Request::respond(std::unique_ptr<Message> response) {
+    if (_completed.exchange(true)) {
+        return false;
+    }
+    if (!response) {
+        return true;
+    }
+    auto snmp = _snmp.lock();
+    if (!snmp) {
+        return false;
+    }
+    // The request is kept alive until sent, the response may borrow its community
+    std::shared_ptr<Message> message(std::move(response));
+    asio::post(snmp->_io_context, [snmp, self = shared_from_this(), message]() {
+        snmp->send(message.get(), self->_remote, self->_port);
+    });
+    return true;
+}
+
 // Agent constructor
 Agent::Agent(asio::io_context& io_context)
     : SNMP(io_context, Port::SNMP)
@@ -0,0 +1,214 @@
+#include "snmp_acl.h"
+#include <asio.hpp>
+#include <bit>
+#include <cctype>
+#include <cstring>
+
+namespace SNMP {
+
+namespace {
+
+// Gets the bit at a given position, most significant bit first
+inline uint8_t bitAt(const uint8_t *key, const uint8_t position) {
+    return (key[position >> 3] >> (7 - (position & 7))) & 1;
+}
+
+// Counts the leading bits shared by two keys, up to a limit
+uint8_t commonBits(const uint8_t *a, const uint8_t *b, const uint8_t limit) {
+    uint8_t bits = 0;
+    for (uint8_t index = 0; bits < limit; ++index, bits += 8) {
+        uint8_t difference = a[index] ^ b[index];
+        if (difference) {
+            bits += std::countl_zero(difference);
+            break;
+        }
+    }
+    return bits < limit ? bits : limit;
+}
+
+} // namespace
+
+// Create a node with a normalized key
+uint32_t PrefixTrie::create(const uint8_t *key, const uint8_t bits, const uint64_t mask) {
+    Node node;
+    memset(node._key, 0, KEY);
+    memcpy(node._key, key, (bits + 7) >> 3);
+    if (bits & 7) {
+        node._key[bits >> 3] &= 0xFF << (8 - (bits & 7));
+    }
+    node._bits = bits;
+    node._mask = mask;
+    node._children[0] = NONE;
+    node._children[1] = NONE;
+    _nodes.push_back(node);
+    return _nodes.size() - 1;
+}
+
+// Insert a prefix, splitting compressed paths where needed
+void PrefixTrie::insert(const uint8_t *key, const uint8_t bits, const uint64_t mask) {
+    uint32_t parent = NONE;
+    uint8_t side = 0;
+    uint32_t index = _root;
+    uint32_t created;
+    while (true) {
+        if (index == NONE) {
+            created = create(key, bits, mask);
+            break;
+        }
+        Node &node = _nodes[index];
+        uint8_t common = commonBits(node._key, key, node._bits < bits ? node._bits : bits);
+        if (common == node._bits) {
+            if (bits == node._bits) {
+                node._mask |= mask;
+                return;
+            }
+            // Node is a prefix of the key, go down
+            parent = index;
+            side = bitAt(key, node._bits);
+            index = node._children[side];
+            continue;
+        }
+        if (common == bits) {
+            // Key is a prefix of the node, insert above
+            created = create(key, bits, mask);
+            _nodes[created]._children[bitAt(_nodes[index]._key, bits)] = index;
+        } else {
+            // Key and node diverge, insert a branching node
+            created = create(key, common, 0);
+            uint32_t leaf = create(key, bits, mask);
+            _nodes[created]._children[bitAt(key, common)] = leaf;
+            _nodes[created]._children[bitAt(_nodes[index]._key, common)] = index;
+        }
+        break;
+    }
+    if (parent == NONE) {
+        _root = created;
+    } else {
+        _nodes[parent]._children[side] = created;
+    }
+}
+
+// Collect masks of all prefixes on the path of the key
+uint64_t PrefixTrie::match(const uint8_t *key, const uint8_t bits) const {
+    uint64_t mask = 0;
+    uint32_t index = _root;
+    while (index != NONE) {
+        const Node &node = _nodes[index];
+        if (node._bits > bits) {
+            break;
+        }
+        uint8_t bytes = node._bits >> 3;
+        if (memcmp(node._key, key, bytes) != 0) {
+            break;
+        }
+        if ((node._bits & 7) && ((node._key[bytes] ^ key[bytes]) & (0xFF << (8 - (node._bits & 7))) & 0xFF)) {
+            break;
+        }
+        mask |= node._mask;
+        if (node._bits == bits) {
+            break;
+        }
+        index = node._children[bitAt(key, node._bits)];
+    }
+    return mask;
+}
+
+// Remove all prefixes
+void PrefixTrie::clear() {
+    _nodes.clear();
+    _root = NONE;
+}
+
+// Get or assign the mask bit of a community
+uint64_t AccessControl::bind(const char *community) {
+    if (!community) {
+        return ANY;
+    }
+    auto it = _communities.find(std::string_view(community));
+    if (it != _communities.end()) {
+        return it->second;
+    }
+    if (_communities.size() >= COMMUNITIES) {
+        return 0;
+    }
+    uint64_t mask = ANY << (_communities.size() + 1);
+    _communities.emplace(community, mask);
+    return mask;
+}
+
+// Allow a community from a prefix given as bytes
+bool AccessControl::allow(const char *community, const uint8_t *address, const uint8_t size, uint8_t length) {
+    uint64_t mask = bind(community);
+    if (!mask) {
+        return false;
+    }
+    if (length > size * 8) {
+        length = size * 8;
+    }
+    (size == 4 ? _v4 : _v6).insert(address, length, mask);
+    _empty = false;
+    return true;
+}
+
+// Allow a community from a prefix given as a string
+bool AccessControl::allow(const char *community, const char *prefix) {
+    if (!prefix) {
+        return false;
+    }
+    std::string text(prefix);
+    long length = -1;
+    size_t slash = text.find('/');
+    if (slash != std::string::npos) {
+        // Digits only, an empty length would be a /0 prefix
+        const char *start = text.c_str() + slash + 1;
+        char *end = nullptr;
+        length = strtol(start, &end, 10);
+        if ((end == start) || *end || !isdigit(static_cast<unsigned char>(*start))) {
+            return false;
+        }
+        text.resize(slash);
+    }
+    asio::error_code ec;
+    asio::ip::address address = asio::ip::make_address(text, ec);
+    if (ec) {
+        return false;
+    }
+    const long width = address.is_v4() ? 32 : 128;
+    if (length > width) {
+        return false;
+    }
+    if (address.is_v4()) {
+        auto bytes = address.to_v4().to_bytes();
+        return allow(community, bytes.data(), 4, length < 0 ? width : length);
+    }
+    auto bytes = address.to_v6().to_bytes();
+    return allow(community, bytes.data(), 16, length < 0 ? width : length);
+}
+
+// Allow a community from an IPv4 or IPv6 prefix
+bool AccessControl::allow(const char *community, const IPAddress &address, const uint8_t length) {
+    return allow(community, address.raw_address(), address.size(), length);
+}
+
+// Check a community from a source address
+bool AccessControl::check(std::string_view community, const uint8_t *address, const uint8_t size) const {
+    if (_empty) {
+        return true;
+    }
+    uint64_t allowed = ANY;
+    auto it = _communities.find(community);
+    if (it != _communities.end()) {
+        allowed |= it->second;
+    }
+    return (size == 4 ? _v4 : _v6).match(address, size * 8) & allowed;
+}
+
+// Remove all entries
+void AccessControl::clear() {
+    _v4.clear();
+    _v6.clear();
+    _communities.clear();
+    _empty = true;
+}
+
+} // namespace SNMP
@@ -0,0 +1,63 @@
+#include "snmp_epoch.h"
+#include <thread>
+
+namespace SNMP {
+
+// Epoch destructor
+Epoch::~Epoch() {
+    for (Retired &retired : _retired) {
+        retired._release();
+    }
+}
+
+// Retire a resource
+void Epoch::retire(std::function<void()> release) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // Readers entered after the increment can't see the resource, it was unpublished before
+    _retired.push_back(Retired { _epoch.fetch_add(1), std::move(release) });
+    this->release();
+}
+
+// Release retired resources
+void Epoch::reclaim() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    release();
+}
+
+// Take a reader slot
+size_t Epoch::enter() {
+    // Threads start from different slots, so they usually get the first one tried
+    static thread_local const size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+    while (true) {
+        for (size_t offset = 0; offset < SLOTS; ++offset) {
+            size_t slot = (start + offset) % SLOTS;
+            uint64_t expected = IDLE;
+            if (_slots[slot]._epoch.compare_exchange_strong(expected, _epoch.load())) {
+                return slot;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+// Release retired resources older than all readers
+void Epoch::release() {
+    uint64_t oldest = UINT64_MAX;
+    for (Slot &slot : _slots) {
+        uint64_t epoch = slot._epoch.load();
+        if ((epoch != IDLE) && (epoch < oldest)) {
+            oldest = epoch;
+        }
+    }
+    size_t kept = 0;
+    for (size_t index = 0; index < _retired.size(); ++index) {
+        if (_retired[index]._epoch < oldest) {
+            _retired[index]._release();
+        } else if (kept++ != index) {
+            _retired[kept - 1] = std::move(_retired[index]);
+        }
+    }
+    _retired.resize(kept);
+}
+
+} // namespace SNMP
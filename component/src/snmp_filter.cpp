@@ -0,0 +1,119 @@
+#include "snmp_filter.h"
+#include "ber.h"
+
+namespace SNMP {
+
+namespace {
+
+// Reads a BER length, checking it fits in the remaining bytes
+bool readLength(const uint8_t *&pointer, const uint8_t *end, size_t &length) {
+    if (pointer >= end) {
+        return false;
+    }
+    length = *pointer++;
+    if (length & 0x80) {
+        uint8_t size = length & 0x7F;
+        // Datagrams are far below 4 GiB, longer lengths are malformed
+        if (size == 0 || size > 4 || end - pointer < size) {
+            return false;
+        }
+        length = 0;
+        while (size--) {
+            length = (length << 8) | *pointer++;
+        }
+    }
+    return length <= static_cast<size_t>(end - pointer);
+}
+
+} // namespace
+
+// Peek version, community and PDU type from a raw datagram
+bool Filter::peek(const uint8_t *data, size_t length, Header &header) {
+    const uint8_t *pointer = data;
+    const uint8_t *end = data + length;
+    size_t size;
+
+    // Message SEQUENCE
+    if (length < 2 || *pointer++ != Type::Sequence || !readLength(pointer, end, size)) {
+        return false;
+    }
+    end = pointer + size;
+
+    // Version INTEGER
+    if (pointer >= end || *pointer++ != Type::Integer || !readLength(pointer, end, size)
+            || size == 0 || size > 4) {
+        return false;
+    }
+    int32_t version = *pointer & 0x80 ? -1 : 0;
+    while (size--) {
+        version = (version << 8) | *pointer++;
+    }
+    if (version < 0 || version > 0xFF) {
+        return false;
+    }
+    header._version = version;
+
+    // Community OCTET STRING
+    if (pointer >= end || *pointer++ != Type::OctetString || !readLength(pointer, end, size)) {
+        return false;
+    }
+    header._community = reinterpret_cast<const char*>(pointer);
+    header._communityLength = size;
+    pointer += size;
+
+    // PDU type
+    if (pointer >= end) {
+        return false;
+    }
+    header._type = *pointer;
+    return true;
+}
+
+// Check a received datagram against version, community and source
+uint8_t Filter::check(const uint8_t *data, size_t length, const IPAddress &remote) {
+    Header header;
+    uint8_t verdict = Verdict::Accept;
+    if (!peek(data, length, header)) {
+        verdict = Verdict::Malformed;
+    } else if (header._version != Version::V1 && header._version != Version::V2C) {
+        verdict = Verdict::BadVersion;
+    } else if (!_communities.empty() && _communities.find(header.getCommunity()) == _communities.end()) {
+        verdict = Verdict::BadCommunity;
+    } else if (!_acl.check(header.getCommunity(), remote)) {
+        verdict = Verdict::BadSource;
+    }
+    if (verdict != Verdict::Accept) {
+        _rejected++;
+    }
+    return verdict;
+}
+
+// Add an accepted community
+void Filter::addCommunity(const char *community) {
+    if (community) {
+        _communities.emplace(community);
+    }
+}
+
+// Remove an accepted community
+void Filter::removeCommunity(const char *community) {
+    if (community) {
+        auto it = _communities.find(std::string_view(community));
+        if (it != _communities.end()) {
+            _communities.erase(it);
+        }
+    }
+}
+
+// Allow a source address for any community
+void Filter::allowSource(const IPAddress &address) {
+    _acl.allow(nullptr, address);
+}
+
+// Remove all communities and access control entries
+void Filter::clear() {
+    _communities.clear();
+    _acl.clear();
+}
+
+} // namespace SNMP
@@ -0,0 +1,224 @@
+#include "snmp_image.h"
+#include <algorithm>
+#include <cstring>
+#ifndef ESP_PLATFORM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !SNMP_STREAM
+namespace SNMP {
+
+namespace {
+
+// Byte order mark
+constexpr uint32_t ORDER = 0x01020304;
+
+// Compare arcs
+inline bool less(const uint32_t *a, const size_t sizeA, const uint32_t *b, const size_t sizeB) {
+    return std::lexicographical_compare(a, a + sizeA, b, b + sizeB);
+}
+
+} // namespace
+
+// Add an instance
+bool ImageBuilder::add(const ObjectIdentifier &oid, BER *value, const uint8_t access) {
+    if (oid.empty() || (oid.size() > UINT16_MAX)) {
+        delete value;
+        return false;
+    }
+    auto it = std::lower_bound(_objects.begin(), _objects.end(), oid, [](const Object &object, const ObjectIdentifier &oid) {
+        return object._oid < oid;
+    });
+    if ((it != _objects.end()) && (it->_oid == oid)) {
+        delete value;
+        return false;
+    }
+    Object object { oid, access, std::vector<uint8_t>(value->getSize(true)) };
+    value->encode(object._value.data());
+    delete value;
+    _objects.insert(it, std::move(object));
+    return true;
+}
+
+// Build the image
+std::vector<uint8_t> ImageBuilder::build() const {
+    size_t arcs = 0;
+    size_t values = 0;
+    for (const Object &object : _objects) {
+        arcs += object._oid.size();
+        values += object._value.size();
+    }
+    Image::Header header;
+    memcpy(header._magic, Image::MAGIC, sizeof(header._magic));
+    header._order = ORDER;
+    header._version = Image::VERSION;
+    header._count = _objects.size();
+    header._records = sizeof(Image::Header);
+    header._arcs = header._records + _objects.size() * sizeof(Image::Record);
+    header._values = header._arcs + arcs * sizeof(uint32_t);
+    header._size = header._values + values;
+
+    std::vector<uint8_t> image(header._size);
+    memcpy(image.data(), &header, sizeof(header));
+    uint8_t *records = image.data() + header._records;
+    uint32_t *arc = reinterpret_cast<uint32_t*>(image.data() + header._arcs);
+    uint8_t *value = image.data() + header._values;
+    Image::Record record { 0, 0, 0, 0, 0, 0 };
+    for (const Object &object : _objects) {
+        record._length = object._oid.size();
+        record._access = object._access;
+        record._size = object._value.size();
+        memcpy(records, &record, sizeof(record));
+        records += sizeof(record);
+        memcpy(arc + record._arcs, object._oid.data(), object._oid.size() * sizeof(uint32_t));
+        memcpy(value + record._value, object._value.data(), object._value.size());
+        record._arcs += record._length;
+        record._value += record._size;
+    }
+    return image;
+}
+
+// Map an image file
+std::shared_ptr<Image> Image::open(const char *path) {
+#ifdef ESP_PLATFORM
+    return nullptr;
+#else
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat status;
+    if ((fstat(fd, &status) != 0) || (static_cast<size_t>(status.st_size) < sizeof(Header))) {
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = status.st_size;
+    void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return nullptr;
+    }
+    std::shared_ptr<const void> owner(map, [size](const void *map) {
+        munmap(const_cast<void*>(map), size);
+    });
+    return load(static_cast<const uint8_t*>(map), size, owner);
+#endif
+}
+
+// Check and serve an image
+std::shared_ptr<Image> Image::load(const uint8_t *data, const size_t size, std::shared_ptr<const void> owner) {
+    if (!data || (size < sizeof(Header)) || (reinterpret_cast<uintptr_t>(data) % alignof(Header))) {
+        return nullptr;
+    }
+    const Header *header = reinterpret_cast<const Header*>(data);
+    if ((memcmp(header->_magic, MAGIC, sizeof(MAGIC)) != 0) || (header->_order != ORDER)
+            || (header->_version != VERSION) || (header->_size > size)) {
+        return nullptr;
+    }
+    // Areas in order, aligned and within the image
+    if ((header->_records < sizeof(Header)) || (header->_records % alignof(Record))
+            || (header->_arcs % alignof(uint32_t))
+            || ((header->_arcs - header->_records) / sizeof(Record) < header->_count)
+            || (header->_arcs < header->_records) || (header->_values < header->_arcs)
+            || (header->_size < header->_values)) {
+        return nullptr;
+    }
+    const Record *records = reinterpret_cast<const Record*>(data + header->_records);
+    const uint32_t *arcs = reinterpret_cast<const uint32_t*>(data + header->_arcs);
+    const size_t arcCount = (header->_values - header->_arcs) / sizeof(uint32_t);
+    const size_t valueSize = header->_size - header->_values;
+    // Records within the areas and strictly sorted, so lookups can't go astray
+    for (uint32_t index = 0; index < header->_count; ++index) {
+        const Record &record = records[index];
+        if (!record._length || (record._arcs > arcCount) || (record._length > arcCount - record._arcs)
+                || (record._size < 2) || (record._value > valueSize) || (record._size > valueSize - record._value)) {
+            return nullptr;
+        }
+        if (index) {
+            const Record &previous = records[index - 1];
+            if (!less(arcs + previous._arcs, previous._length, arcs + record._arcs, record._length)) {
+                return nullptr;
+            }
+        }
+    }
+    return std::shared_ptr<Image>(new Image(data, std::move(owner)));
+}
+
+// Image constructor
+Image::Image(const uint8_t *data, std::shared_ptr<const void> owner) :
+        _owner(std::move(owner)) {
+    const Header *header = reinterpret_cast<const Header*>(data);
+    _records = reinterpret_cast<const Record*>(data + header->_records);
+    _arcs = reinterpret_cast<const uint32_t*>(data + header->_arcs);
+    _values = data + header->_values;
+    _count = header->_count;
+}
+
+// Get the value of an instance
+BER* Image::get(const ObjectIdentifier &oid) {
+    uint32_t index = find(oid, true);
+    if (index == _count) {
+        return nullptr;
+    }
+    const Record &record = _records[index];
+    if (!readable(record) || (record._length != oid.size())
+            || !std::equal(oid.data(), oid.data() + oid.size(), _arcs + record._arcs)) {
+        return nullptr;
+    }
+    return value(record);
+}
+
+// Find the instance following an OID
+bool Image::next(const ObjectIdentifier &oid, ObjectIdentifier &next) {
+    for (uint32_t index = find(oid, false); index < _count; ++index) {
+        if (readable(_records[index])) {
+            next = name(_records[index]);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Walk the instances following an OID
+size_t Image::walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances) {
+    size_t appended = 0;
+    for (uint32_t index = find(oid, false); (index < _count) && (appended < count); ++index) {
+        const Record &record = _records[index];
+        if (readable(record)) {
+            instances.push_back(Instance { name(record), value(record) });
+            appended++;
+        }
+    }
+    return appended;
+}
+
+// Find the first record not before an OID
+uint32_t Image::find(const ObjectIdentifier &oid, const bool inclusive) const {
+    const Record *end = _records + _count;
+    if (inclusive) {
+        return std::lower_bound(_records, end, oid, [this](const Record &record, const ObjectIdentifier &oid) {
+            return less(_arcs + record._arcs, record._length, oid.data(), oid.size());
+        }) - _records;
+    }
+    return std::upper_bound(_records, end, oid, [this](const ObjectIdentifier &oid, const Record &record) {
+        return less(oid.data(), oid.size(), _arcs + record._arcs, record._length);
+    }) - _records;
+}
+
+// Get the OID of a record
+ObjectIdentifier Image::name(const Record &record) const {
+    ObjectIdentifier oid;
+    oid.append(_arcs + record._arcs, record._length);
+    return oid;
+}
+
+// Create the value of a record
+BER* Image::value(const Record &record) const {
+    return new EncodedBER(_values + record._value, record._size, _owner);
+}
+
+} // namespace SNMP
+#endif
@@ -0,0 +1,314 @@
+#include "snmp_message.h"
+
+namespace SNMP {
+
+#if !SNMP_STREAM
+namespace {
+
+// Reads a BER length, checking it fits in the remaining bytes
+bool readLength(const uint8_t *&pointer, const uint8_t *end, size_t &length) {
+    if (pointer >= end) {
+        return false;
+    }
+    length = *pointer++;
+    if (length & 0x80) {
+        uint8_t size = length & 0x7F;
+        // Datagrams are far below 4 GiB, longer lengths are malformed
+        if (size == 0 || size > 4 || end - pointer < size) {
+            return false;
+        }
+        length = 0;
+        while (size--) {
+            length = (length << 8) | *pointer++;
+        }
+    }
+    return length <= static_cast<size_t>(end - pointer);
+}
+
+// Reads a BER type and length, checking the type
+inline bool readHeader(const uint8_t *&pointer, const uint8_t *end, const uint8_t type, size_t &length) {
+    return (pointer < end) && (*pointer++ == type) && readLength(pointer, end, length);
+}
+
+// Reads an INTEGER of at most 4 bytes
+bool readInteger(const uint8_t *&pointer, const uint8_t *end, int32_t &value) {
+    size_t length;
+    if (!readHeader(pointer, end, Type::Integer, length) || (length == 0) || (length > 4)) {
+        return false;
+    }
+    value = *pointer & 0x80 ? -1 : 0;
+    while (length--) {
+        value = (value << 8) | *pointer++;
+    }
+    return true;
+}
+
+/** Nesting depth of the BERs embedded in a value. */
+constexpr uint8_t MAXIMUM_DEPTH = 8;
+
+// Checks a value is well formed, the BER decoders don't check bounds
+bool checkValue(const uint8_t *&pointer, const uint8_t *end, const uint8_t depth = 0) {
+    size_t length;
+    if (pointer >= end) {
+        return false;
+    }
+    const uint8_t type = *pointer++;
+    if (!readLength(pointer, end, length)) {
+        return false;
+    }
+    const uint8_t *content = pointer;
+    pointer += length;
+    switch (type) {
+    case Type::Boolean:
+        return length == 1;
+    case Type::Integer:
+        return (length > 0) && (length <= 8);
+    case Type::Counter32:
+    case Type::Gauge32:
+    case Type::TimeTicks:
+        return (length > 0) && (length <= 5);
+    case Type::Counter64:
+        return (length > 0) && (length <= 9);
+    case Type::OctetString:
+        return true;
+    case Type::IPAddress:
+        return length == 4;
+    case Type::ObjectIdentifier:
+        // A malformed OID decodes as empty
+        return length > 0;
+    case Type::Null:
+    case Type::NoSuchObject:
+    case Type::NoSuchInstance:
+    case Type::EndOfMIBView:
+        return length == 0;
+    case Type::Opaque:
+        // A single embedded BER, an OpaqueFloat has a two bytes type
+        if ((length == 7) && (content[0] == 0x9F) && (content[1] == 0x78) && (content[2] == 4)) {
+            return true;
+        }
+        return (depth < MAXIMUM_DEPTH) && checkValue(content, pointer, depth + 1) && (content == pointer);
+    case Type::Sequence:
+        while (content < pointer) {
+            if ((depth == MAXIMUM_DEPTH) || !checkValue(content, pointer, depth + 1)) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+#endif
+
+// Get the count of variable bindings
+uint32_t Message::getBindingCount() const {
+#if !SNMP_STREAM
+    if (!_data.empty()) {
+        return _entries.size();
+    }
+#endif
+    return _varBindList ? _varBindList->count() : 0;
+}
+
+// Get the name of a variable binding
+bool Message::getName(const uint32_t index, ObjectIdentifier &oid) const {
+    if (index >= getBindingCount()) {
+        oid = ObjectIdentifier();
+        return false;
+    }
+#if !SNMP_STREAM
+    if (!_data.empty()) {
+        return oid.decode(_data.data() + _entries[index]._name, _entries[index]._nameLength);
+    }
+#endif
+    return oid.parse((*_varBindList)[index]->getName());
+}
+
+// Get the BER type of the value of a variable binding
+uint8_t Message::getValueType(const uint32_t index) const {
+    if (index >= getBindingCount()) {
+        return 0;
+    }
+#if !SNMP_STREAM
+    if (!_data.empty()) {
+        return _entries[index]._type;
+    }
+#endif
+    BER *value = (*_varBindList)[index]->getValue();
+    return value ? value->getType() : 0;
+}
+
+#if !SNMP_STREAM
+// Create the value of a variable binding
+BER* Message::createValue(const uint32_t index) const {
+    if (index >= getBindingCount()) {
+        return nullptr;
+    }
+    std::vector<uint8_t> encoded;
+    uint8_t *pointer;
+    if (!_data.empty()) {
+        // Decoding doesn't write to the buffer
+        pointer = const_cast<uint8_t*>(_data.data()) + _entries[index]._value;
+    } else {
+        BER *value = (*_varBindList)[index]->getValue();
+        if (!value) {
+            return nullptr;
+        }
+        encoded.resize(value->getSize(true));
+        value->encode(encoded.data());
+        pointer = encoded.data();
+    }
+    Type type;
+    type.decode(pointer);
+    BER *ber = const_cast<Message*>(this)->create(type);
+    if (ber) {
+        ber->decode(pointer);
+    }
+    return ber;
+}
+
+// Index the message from a datagram
+bool Message::index(std::vector<uint8_t> &data) {
+    const uint8_t *begin = data.data();
+    const uint8_t *pointer = begin;
+    const uint8_t *end = begin + data.size();
+    size_t length;
+
+    // Message SEQUENCE, version INTEGER and community OCTET STRING
+    int32_t version;
+    if (!readHeader(pointer, end, Type::Sequence, length)) {
+        return false;
+    }
+    end = pointer + length;
+    if (!readInteger(pointer, end, version) || !readHeader(pointer, end, Type::OctetString, length)) {
+        return false;
+    }
+    const char *community = reinterpret_cast<const char*>(pointer);
+    const size_t communityLength = length;
+    pointer += length;
+
+    // PDU
+    if ((pointer >= end) || (*pointer < Type::GetRequest) || (*pointer > Type::Report)) {
+        return false;
+    }
+    const uint8_t type = *pointer;
+    if (!readHeader(pointer, end, type, length)) {
+        return false;
+    }
+    end = pointer + length;
+    int32_t requestID = 0;
+    int32_t first = 0;
+    int32_t second = 0;
+    const uint8_t *enterprise = nullptr;
+    uint8_t address[4] = {};
+    uint64_t timeStamp = 0;
+    if (type == Type::Trap) {
+        // Enterprise, agent address, generic and specific traps and time stamp of a version 1 Trap
+        enterprise = pointer;
+        if (!readHeader(pointer, end, Type::ObjectIdentifier, length)) {
+            return false;
+        }
+        pointer += length;
+        if (!readHeader(pointer, end, Type::IPAddress, length) || (length != sizeof(address))) {
+            return false;
+        }
+        memcpy(address, pointer, sizeof(address));
+        pointer += length;
+        if (!readInteger(pointer, end, first) || !readInteger(pointer, end, second)
+                || !readHeader(pointer, end, Type::TimeTicks, length) || (length == 0) || (length > 5)) {
+            return false;
+        }
+        while (length--) {
+            timeStamp = (timeStamp << 8) | *pointer++;
+        }
+    } else if (!readInteger(pointer, end, requestID) || !readInteger(pointer, end, first)
+            || !readInteger(pointer, end, second)) {
+        // Request identifier and error or bulk integers of other PDUs
+        return false;
+    }
+    if (!readHeader(pointer, end, Type::Sequence, length)) {
+        return false;
+    }
+
+    // Variable bindings, name and value of each one located without being decoded
+    end = pointer + length;
+    std::vector<VarBindView::Entry> entries;
+    while (pointer < end) {
+        if (!readHeader(pointer, end, Type::Sequence, length)) {
+            return false;
+        }
+        const uint8_t *next = pointer + length;
+        VarBindView::Entry entry;
+        if (!readHeader(pointer, next, Type::ObjectIdentifier, length)) {
+            return false;
+        }
+        entry._name = pointer - begin;
+        entry._nameLength = length;
+        pointer += length;
+        entry._value = pointer - begin;
+        if (pointer >= next) {
+            return false;
+        }
+        entry._type = *pointer++;
+        if (!readLength(pointer, next, length) || (pointer + length != next)) {
+            return false;
+        }
+        entry._header = pointer - begin - entry._value;
+        entry._valueSize = next - begin - entry._value;
+        // Values are decoded on access, by unchecked decoders
+        const uint8_t *value = begin + entry._value;
+        if (!checkValue(value, next)) {
+            return false;
+        }
+        entries.push_back(entry);
+        pointer = next;
+    }
+
+    // The header is kept as decoded BERs, as by parse()
+    OctetStringBER *value = new OctetStringBER(community, communityLength);
+    ArrayBER::add(new IntegerBER(version));
+    ArrayBER::add(value);
+    _version = version;
+    _community = value->getValue();
+    _type = type;
+    if (type == Type::Trap) {
+        ObjectIdentifierBER *oid = new ObjectIdentifierBER(nullptr);
+        oid->decode(data.data() + (enterprise - begin));
+        ArrayBER::add(oid);
+        _trap._enterprise = oid->getValue();
+        _trap._agentAddr = IPAddress(address[0], address[1], address[2], address[3]);
+        _trap._genericTrap = first;
+        _trap._specificTrap = second;
+        _trap._timeStamp = timeStamp;
+    } else if (type == Type::GetBulkRequest) {
+        _generic._requestID = requestID;
+        // Negative values are taken as 0, RFC 3416 section 4.2.3
+        _generic._bulk._nonRepeaters = std::max(first, 0);
+        _generic._bulk._maxRepetitions = std::max(second, 0);
+    } else {
+        _generic._requestID = requestID;
+        _generic._error._status = first;
+        _generic._error._index = second;
+    }
+    delete _varBindList;
+    _varBindList = nullptr;
+    _entries = std::move(entries);
+    _data.swap(data);
+    return true;
+}
+
+// Decode the variable bindings list of an indexed message
+void Message::materialize() const {
+    _varBindList = new VarBindList();
+    ObjectIdentifier oid;
+    for (uint32_t index = 0; index < _entries.size(); ++index) {
+        getName(index, oid);
+        _varBindList->add(new VarBind(oid.toString().c_str(), createValue(index)));
+    }
+}
+
+#endif
+
+} // namespace SNMP
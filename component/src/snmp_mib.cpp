@@ -0,0 +1,711 @@
+#include "snmp_mib.h"
+#include <algorithm>
+#include <string>
+
+namespace SNMP {
+
+namespace {
+
+// Compares an OID with the subtree of a registration
+template<typename T>
+inline bool before(const ObjectIdentifier &oid, const T &registration) {
+    return oid < registration._subtree;
+}
+
+// Checks if a BER encoded OID is in the subtree of a registration
+template<typename T>
+inline bool inside(const uint8_t *oid, const size_t length, const T &registration) {
+    if (registration._subtree.size() > 1) {
+        return ObjectIdentifier::startsWith(oid, length, registration._encoded.data(), registration._encoded.size());
+    }
+    // A single arc is combined with the second one in the first subidentifier
+    uint64_t first = 0;
+    for (size_t position = 0; (position < length) && (position < 5); ++position) {
+        first = (first << 7) | (oid[position] & 0x7F);
+        if (!(oid[position] & 0x80)) {
+            return ((first < 80) ? first / 40 : 2) == registration._subtree[0];
+        }
+    }
+    return false;
+}
+
+#if !SNMP_STREAM
+// Copies a value of a request, for the response
+BER* copy(BER *value) {
+    auto encoded = std::make_shared<std::vector<uint8_t>>(value->getSize(true));
+    value->encode(encoded->data());
+    return new EncodedBER(encoded);
+}
+#endif
+
+#if !SNMP_STREAM
+// Hashes the bytes identifying the requests answered by the same evaluation, FNV-1a
+uint64_t signature(const Message *request) {
+    uint64_t hash = 0xCBF29CE484222325;
+    auto mix = [&hash](const uint64_t value, const size_t size) {
+        for (size_t index = 0; index < size; ++index) {
+            hash = (hash ^ ((value >> (8 * index)) & 0xFF)) * 0x100000001B3;
+        }
+    };
+    mix(request->getVersion(), 1);
+    mix(request->getType(), 1);
+    if (request->getType() == Type::GetBulkRequest) {
+        mix(request->getNonRepeaters(), 4);
+        mix(request->getMaxRepetition(), 4);
+    }
+    // Encoded names, as received, each one after its length
+    for (const RawVarBind binding : request->getBindings()) {
+        mix(binding._name.size(), 4);
+        for (const uint8_t byte : binding._name) {
+            mix(byte, 1);
+        }
+    }
+    return hash;
+}
+
+// Checks two requests with the same signature are identical
+bool identical(const Message *a, const Message *b) {
+    if ((a->getVersion() != b->getVersion()) || (a->getType() != b->getType())
+            || (a->getBindingCount() != b->getBindingCount())) {
+        return false;
+    }
+    if ((a->getType() == Type::GetBulkRequest) && ((a->getNonRepeaters() != b->getNonRepeaters())
+            || (a->getMaxRepetition() != b->getMaxRepetition()))) {
+        return false;
+    }
+    const VarBindView bindingsA = a->getBindings();
+    const VarBindView bindingsB = b->getBindings();
+    for (size_t index = 0; index < bindingsA.size(); ++index) {
+        const std::span<const uint8_t> nameA = bindingsA[index]._name;
+        const std::span<const uint8_t> nameB = bindingsB[index]._name;
+        if (!std::equal(nameA.begin(), nameA.end(), nameB.begin(), nameB.end())) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+// Releases the values of lookups not added to a response
+void release(std::vector<Lookup> &lookups) {
+    for (Lookup &lookup : lookups) {
+        for (Instance &instance : lookup._instances) {
+            delete instance._value;
+            instance._value = nullptr;
+        }
+    }
+}
+
+// Builds an error response echoing the request variable bindings, setError() maps the status to version 1
+std::unique_ptr<Message> failure(const Message *request, const uint8_t status, const uint32_t index) {
+    auto response = std::make_unique<Message>(request->getVersion(), request->getCommunity(), Type::GetResponse);
+    response->setRequestID(request->getRequestID());
+    ObjectIdentifier oid;
+    for (uint32_t position = 0; position < request->getBindingCount(); ++position) {
+        request->getName(position, oid);
+        response->add(oid.toString().c_str());
+    }
+    response->setError(status, index);
+    return response;
+}
+
+} // namespace
+
+// Walk instances with next() and get()
+size_t Provider::walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances) {
+    size_t appended = 0;
+    ObjectIdentifier from = oid;
+    ObjectIdentifier found;
+    while ((appended < count) && next(from, found) && (from < found)) {
+        from = found;
+        BER *value = get(found);
+        // Skip instances removed meanwhile
+        if (value) {
+            instances.push_back(Instance { found, value });
+            appended++;
+        }
+    }
+    return appended;
+}
+
+// Read lookups one by one with get() and walk()
+void Provider::lookup(const std::vector<Lookup*> &lookups) {
+    for (Lookup *lookup : lookups) {
+        if (lookup->_count) {
+            walk(lookup->_oid, lookup->_count, lookup->_instances);
+        } else {
+            BER *value = get(lookup->_oid);
+            if (value) {
+                lookup->_instances.push_back(Instance { lookup->_oid, value });
+            }
+        }
+    }
+}
+
+// MIB constructor
+MIB::MIB(const size_t threads) :
+        _pool(threads) {
+}
+
+// MIB destructor
+MIB::~MIB() {
+    _pool.stop();
+    _pool.join();
+}
+
+// Register a provider for a subtree
+bool MIB::add(const char *subtree, std::shared_ptr<Provider> provider, const CachePolicy &policy) {
+    ObjectIdentifier oid(subtree);
+    if (oid.empty() || !provider) {
+        return false;
+    }
+    auto it = std::lower_bound(_registrations.begin(), _registrations.end(), oid,
+            [](const Registration &registration, const ObjectIdentifier &oid) {
+                return registration._subtree < oid;
+            });
+    // Registrations don't overlap, so only the neighbours can contain or be contained
+    if ((it != _registrations.end()) && it->_subtree.startsWith(oid)) {
+        return false;
+    }
+    if ((it != _registrations.begin()) && oid.startsWith((it - 1)->_subtree)) {
+        return false;
+    }
+    // A single arc is encoded as its first subidentifier, before all the OIDs of its subtree
+    std::vector<uint8_t> encoded(oid.getLength());
+    oid.encode(encoded.data());
+    _registrations.insert(it, Registration { oid, std::move(encoded), provider, policy, std::make_shared<std::mutex>() });
+    return true;
+}
+
+// Register a scalar computed by a callback
+bool MIB::add(const char *oid, ScalarProvider::Callback callback, const CachePolicy &policy) {
+    return add(oid, std::make_shared<ScalarProvider>(ObjectIdentifier(oid), callback), policy);
+}
+
+// Unregister the provider of a subtree
+bool MIB::remove(const char *subtree) {
+    ObjectIdentifier oid(subtree);
+    size_t index = find(oid);
+    if ((index == _registrations.size()) || !(_registrations[index]._subtree == oid)) {
+        return false;
+    }
+    _registrations.erase(_registrations.begin() + index);
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _cache.lower_bound(oid);
+    while ((it != _cache.end()) && it->first.startsWith(oid)) {
+        it = _cache.erase(it);
+    }
+    return true;
+}
+
+// Process a request
+std::unique_ptr<Message> MIB::process(const Message *request) {
+    const uint8_t type = request->getType();
+    if (type == Type::SetRequest) {
+        return set(request);
+    }
+    if ((type != Type::GetRequest) && (type != Type::GetNextRequest) && (type != Type::GetBulkRequest)) {
+        return nullptr;
+    }
+#if SNMP_STREAM
+    return read(request);
+#else
+    // Identical received requests being evaluated share the evaluation
+    if (!request->getBindings().size()) {
+        return read(request);
+    }
+    const uint64_t key = signature(request);
+    std::shared_ptr<Flight> flight;
+    {
+        std::unique_lock<std::mutex> lock(_flightsMutex);
+        auto it = _flights.find(key);
+        if ((it != _flights.end()) && !identical(request, it->second->_request)) {
+            // Another request with the same signature, evaluate alone
+            lock.unlock();
+            return read(request);
+        }
+        if (it != _flights.end()) {
+            flight = it->second;
+            flight->_waiters++;
+            _flightsDone.wait(lock, [&flight]() {
+                return flight->_done;
+            });
+            if (flight->_result) {
+                return respond(request, flight->_result);
+            }
+            // The evaluation failed, evaluate alone
+            lock.unlock();
+            return read(request);
+        }
+        flight = std::make_shared<Flight>();
+        flight->_request = request;
+        _flights.emplace(key, flight);
+    }
+
+    // Ends the evaluation even if read() throws, waiters then evaluate alone
+    struct Landing {
+        MIB &_mib;
+        const uint64_t _key;
+        const std::shared_ptr<Flight> &_flight;
+        std::shared_ptr<const Evaluation> _result;
+
+        ~Landing() {
+            {
+                std::lock_guard<std::mutex> lock(_mib._flightsMutex);
+                auto it = _mib._flights.find(_key);
+                if ((it != _mib._flights.end()) && (it->second == _flight)) {
+                    _mib._flights.erase(it);
+                }
+                _flight->_result = _result;
+                _flight->_done = true;
+            }
+            _mib._flightsDone.notify_all();
+        }
+    } landing { *this, key, flight, nullptr };
+    auto response = read(request);
+    size_t waiters = 0;
+    {
+        std::lock_guard<std::mutex> lock(_flightsMutex);
+        _flights.erase(key);
+        waiters = flight->_waiters;
+    }
+    // No request can join anymore, encode for the waiters only if any
+    if (waiters) {
+        landing._result = capture(*response);
+    }
+    return response;
+#endif
+}
+
+// Process a GetRequest, GetNextRequest or GetBulkRequest
+std::unique_ptr<Message> MIB::read(const Message *request) {
+    const uint8_t type = request->getType();
+    const uint8_t version = request->getVersion();
+    const uint32_t count = request->getBindingCount();
+    uint32_t nonRepeaters = count;
+    uint32_t repetitions = 0;
+    if (type == Type::GetBulkRequest) {
+        nonRepeaters = std::min(request->getNonRepeaters(), count);
+        repetitions = request->getMaxRepetition();
+    }
+
+    // Read all the variable bindings at once, batched by provider
+    const size_t width = count - nonRepeaters;
+    const size_t rows = width && (nonRepeaters < BINDINGS)
+            ? std::min<size_t>(repetitions, (BINDINGS - nonRepeaters + width - 1) / width) : 0;
+    std::vector<Lookup> lookups(rows ? count : nonRepeaters);
+    for (size_t index = 0; index < lookups.size(); ++index) {
+        request->getName(index, lookups[index]._oid);
+        if (type != Type::GetRequest) {
+            lookups[index]._count = index < nonRepeaters ? 1 : rows;
+        }
+    }
+    lookup(lookups);
+    for (size_t index = 0; index < lookups.size(); ++index) {
+        if (lookups[index]._error != Error::NoError) {
+            release(lookups);
+            return failure(request, lookups[index]._error, index + 1);
+        }
+    }
+
+    auto response = std::make_unique<Message>(version, request->getCommunity(), Type::GetResponse);
+    response->setRequestID(request->getRequestID());
+
+    // Get, GetNext and non repeaters of GetBulk
+    for (uint32_t index = 0; index < nonRepeaters; ++index) {
+        const std::string name = lookups[index]._oid.toString();
+        std::vector<Instance> &instances = lookups[index]._instances;
+        if (!instances.empty()) {
+            response->add(type == Type::GetRequest ? name.c_str() : instances[0]._oid.toString().c_str(), instances[0]._value);
+            instances[0]._value = nullptr;
+        } else if (version == Version::V1) {
+            release(lookups);
+            return failure(request, Error::NoSuchName, index + 1);
+        } else if (type != Type::GetRequest) {
+            response->add(name.c_str(), new EndOfMIBViewBER());
+        } else if (find(lookups[index]._oid) == _registrations.size()) {
+            response->add(name.c_str(), new NoSuchObjectBER());
+        } else {
+            response->add(name.c_str(), new NoSuchInstanceBER());
+        }
+    }
+
+    // Repeaters of GetBulk, walked column by column then interleaved row by row
+    unsigned int bindings = nonRepeaters;
+    for (size_t row = 0; (row < rows) && (bindings < BINDINGS); ++row) {
+        bool more = false;
+        for (size_t column = nonRepeaters; (column < count) && (bindings < BINDINGS); ++column, ++bindings) {
+            Lookup &lookup = lookups[column];
+            if (row < lookup._instances.size()) {
+                Instance &instance = lookup._instances[row];
+                response->add(instance._oid.toString().c_str(), instance._value);
+                instance._value = nullptr;
+                more = true;
+            } else {
+                const ObjectIdentifier &last = lookup._instances.empty() ? lookup._oid : lookup._instances.back()._oid;
+                response->add(last.toString().c_str(), new EndOfMIBViewBER());
+            }
+        }
+        if (!more) {
+            break;
+        }
+    }
+    // Release values left out by the size limit
+    release(lookups);
+    return response;
+}
+
+#if !SNMP_STREAM
+// Encode the variable bindings of a response in one block
+std::shared_ptr<const MIB::Evaluation> MIB::capture(const Message &response) {
+    auto evaluation = std::make_shared<Evaluation>();
+    VarBindList *list = response.getVarBindList();
+    size_t size = 0;
+    for (uint32_t index = 0; index < list->count(); ++index) {
+        BER *value = (*list)[index]->getValue();
+        size += value ? value->getSize(true) : 0;
+    }
+    evaluation->_values.resize(size);
+    uint8_t *position = evaluation->_values.data();
+    for (uint32_t index = 0; index < list->count(); ++index) {
+        VarBind *varbind = (*list)[index];
+        BER *value = varbind->getValue();
+        const uint32_t offset = position - evaluation->_values.data();
+        position = value ? value->encode(position) : position;
+        evaluation->_bindings.push_back(Evaluation::Binding { varbind->getName(), offset,
+                static_cast<uint32_t>(position - evaluation->_values.data() - offset) });
+    }
+    evaluation->_status = response.getErrorStatus();
+    evaluation->_index = response.getErrorIndex();
+    return evaluation;
+}
+
+// Build the response of a request from a shared evaluation
+std::unique_ptr<Message> MIB::respond(const Message *request, const std::shared_ptr<const Evaluation> &evaluation) {
+    auto response = std::make_unique<Message>(request->getVersion(), request->getCommunity(), Type::GetResponse);
+    response->setRequestID(request->getRequestID());
+    for (const Evaluation::Binding &binding : evaluation->_bindings) {
+        response->add(binding._name.c_str(), binding._size
+                ? new EncodedBER(evaluation->_values.data() + binding._offset, binding._size, evaluation) : nullptr);
+    }
+    response->setError(evaluation->_status, evaluation->_index);
+    return response;
+}
+#endif
+
+// Get the value of an instance
+BER* MIB::get(const ObjectIdentifier &oid) {
+    size_t index = find(oid);
+    if (index == _registrations.size()) {
+        return new NoSuchObjectBER();
+    }
+    BER *value = this->value(_registrations[index], oid);
+    return value ? value : new NoSuchInstanceBER();
+}
+
+// Get the instance following an OID, across subtrees
+BER* MIB::next(const ObjectIdentifier &oid, ObjectIdentifier &next) {
+    std::vector<Instance> instances;
+    if (!walk(oid, 1, instances)) {
+        return nullptr;
+    }
+    next = instances[0]._oid;
+    return instances[0]._value;
+}
+
+// Walk the instances following an OID, across subtrees
+size_t MIB::walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances) {
+    std::vector<Lookup> lookups(1);
+    lookups[0]._oid = oid;
+    lookups[0]._count = count;
+    lookup(lookups);
+    std::vector<Instance> &found = lookups[0]._instances;
+    instances.insert(instances.end(), found.begin(), found.end());
+    return found.size();
+}
+
+// Read variable bindings, batched by provider
+void MIB::lookup(std::vector<Lookup> &lookups) {
+    if (lookups.empty()) {
+        return;
+    }
+    // Registration each lookup is at, the count of registrations once complete
+    const size_t end = _registrations.size();
+    std::vector<size_t> positions(lookups.size());
+    for (size_t index = 0; index < lookups.size(); ++index) {
+        positions[index] = lookups[index]._count ? first(lookups[index]._oid) : find(lookups[index]._oid);
+    }
+    std::vector<size_t> owners;
+    std::vector<Lookup> batch;
+    std::vector<Lookup*> pointers;
+    ObjectIdentifier found;
+    // Walks only move forward, so visiting subtrees in order calls each provider once
+    for (size_t current = *std::min_element(positions.begin(), positions.end()); current < end;
+            current = *std::min_element(positions.begin(), positions.end())) {
+        const Registration &registration = _registrations[current];
+        owners.clear();
+        for (size_t index = 0; index < lookups.size(); ++index) {
+            if (positions[index] == current) {
+                owners.push_back(index);
+            }
+        }
+        if (registration._policy._ttl) {
+            // Cached values are read one by one through the cache
+            for (size_t index : owners) {
+                Lookup &lookup = lookups[index];
+                if (!lookup._count) {
+                    BER *value = this->value(registration, lookup._oid);
+                    if (value) {
+                        lookup._instances.push_back(Instance { lookup._oid, value });
+                    }
+                    continue;
+                }
+                ObjectIdentifier from = lookup._instances.empty() ? lookup._oid : lookup._instances.back()._oid;
+                while ((lookup._instances.size() < lookup._count) && registration._provider->next(from, found)
+                        && (from < found) && found.startsWith(registration._subtree)) {
+                    from = found;
+                    BER *value = this->value(registration, found);
+                    if (value) {
+                        lookup._instances.push_back(Instance { found, value });
+                    }
+                }
+            }
+        } else {
+            batch.clear();
+            batch.resize(owners.size());
+            pointers.clear();
+            for (size_t index = 0; index < owners.size(); ++index) {
+                const Lookup &lookup = lookups[owners[index]];
+                batch[index]._oid = lookup._instances.empty() ? lookup._oid : lookup._instances.back()._oid;
+                batch[index]._count = lookup._count ? lookup._count - lookup._instances.size() : 0;
+                pointers.push_back(&batch[index]);
+            }
+            registration._provider->lookup(pointers);
+            for (size_t index = 0; index < owners.size(); ++index) {
+                Lookup &lookup = lookups[owners[index]];
+                std::vector<Instance> &instances = batch[index]._instances;
+                // Drop what a walk found past the end of the subtree
+                size_t kept = 0;
+                while ((kept < instances.size()) && (!lookup._count || instances[kept]._oid.startsWith(registration._subtree))) {
+                    kept++;
+                }
+                for (size_t dropped = kept; dropped < instances.size(); ++dropped) {
+                    delete instances[dropped]._value;
+                }
+                lookup._instances.insert(lookup._instances.end(), instances.begin(), instances.begin() + kept);
+                lookup._error = batch[index]._error;
+            }
+        }
+        // Walks not complete go on in the next subtree
+        for (size_t index : owners) {
+            const Lookup &lookup = lookups[index];
+            const bool complete = !lookup._count || (lookup._error != Error::NoError)
+                    || (lookup._instances.size() >= lookup._count);
+            positions[index] = complete ? end : current + 1;
+        }
+    }
+}
+
+// Process a SetRequest, all changes or none
+std::unique_ptr<Message> MIB::set(const Message *request) {
+    const uint8_t version = request->getVersion();
+    VarBindList *list = request->getVarBindList();
+    const uint32_t count = list->count();
+    std::vector<Change> changes(count);
+    std::vector<size_t> registrations(count);
+    for (uint32_t index = 0; index < count; ++index) {
+        changes[index]._oid.parse((*list)[index]->getName());
+        changes[index]._value = (*list)[index]->getValue();
+        registrations[index] = find(changes[index]._oid);
+        if (registrations[index] == _registrations.size()) {
+            return failure(request, Error::NotWritable, index + 1);
+        }
+    }
+
+    // Lock the providers of the request in subtree order, so concurrent SETs can't deadlock
+    std::vector<size_t> providers = registrations;
+    std::sort(providers.begin(), providers.end());
+    providers.erase(std::unique(providers.begin(), providers.end()), providers.end());
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(providers.size());
+    for (size_t index : providers) {
+        locks.emplace_back(*_registrations[index]._lock);
+    }
+
+    uint8_t status = Error::NoError;
+    uint32_t failed = 0;
+    uint32_t tested = 0;
+    for (; tested < count; ++tested) {
+        status = _registrations[registrations[tested]]._provider->test(changes[tested]);
+        if (status != Error::NoError) {
+            failed = tested + 1;
+            break;
+        }
+    }
+    uint32_t committed = 0;
+    if (status == Error::NoError) {
+        for (; committed < count; ++committed) {
+            if (_registrations[registrations[committed]]._provider->commit(changes[committed]) != Error::NoError) {
+                status = Error::CommitFailed;
+                break;
+            }
+        }
+        // Revert in reverse order, the error index is 0 for commitFailed and undoFailed
+        for (uint32_t index = committed; (status != Error::NoError) && index-- > 0;) {
+            if (!_registrations[registrations[index]]._provider->undo(changes[index])) {
+                status = Error::UndoFailed;
+            }
+        }
+    }
+    for (uint32_t index = 0; index < tested; ++index) {
+        _registrations[registrations[index]]._provider->cleanup(changes[index]);
+    }
+    // Cached values of committed changes are stale
+    for (uint32_t index = 0; index < committed; ++index) {
+        invalidate(changes[index]._oid, _registrations[registrations[index]]._policy);
+    }
+    locks.clear();
+
+    if (status != Error::NoError) {
+        return failure(request, status, failed);
+    }
+    auto response = std::make_unique<Message>(version, request->getCommunity(), Type::GetResponse);
+    response->setRequestID(request->getRequestID());
+    for (uint32_t index = 0; index < count; ++index) {
+#if SNMP_STREAM
+        // Values can't be copied in stream mode, read them back
+        response->add((*list)[index]->getName(), get(changes[index]._oid));
+#else
+        response->add((*list)[index]->getName(), copy(changes[index]._value));
+#endif
+    }
+    return response;
+}
+
+// Find the registration of the subtree containing an OID
+size_t MIB::find(const ObjectIdentifier &oid) const {
+    auto it = std::upper_bound(_registrations.begin(), _registrations.end(), oid, before<Registration>);
+    if ((it != _registrations.begin()) && oid.startsWith((it - 1)->_subtree)) {
+        return it - 1 - _registrations.begin();
+    }
+    return _registrations.size();
+}
+
+// Find the registration of the subtree containing a BER encoded OID
+size_t MIB::find(const uint8_t *oid, const size_t length) const {
+    auto it = std::upper_bound(_registrations.begin(), _registrations.end(), length,
+            [oid](const size_t length, const Registration &registration) {
+                return ObjectIdentifier::compare(oid, length, registration._encoded.data(),
+                        registration._encoded.size()) < 0;
+            });
+    if ((it != _registrations.begin()) && inside(oid, length, *(it - 1))) {
+        return it - 1 - _registrations.begin();
+    }
+    return _registrations.size();
+}
+
+// Check if a BER encoded OID is in a registered subtree
+bool MIB::contains(const uint8_t *oid, const size_t length) const {
+    return find(oid, length) != _registrations.size();
+}
+
+// Find the first registration a walk from an OID goes through
+size_t MIB::first(const ObjectIdentifier &oid) const {
+    size_t index = std::upper_bound(_registrations.begin(), _registrations.end(), oid,
+            before<Registration>) - _registrations.begin();
+    if (index && oid.startsWith(_registrations[index - 1]._subtree)) {
+        index--;
+    }
+    return index;
+}
+
+// Get a value from a provider, through its cache
+BER* MIB::value(const Registration &registration, const ObjectIdentifier &oid) {
+    const CachePolicy &policy = registration._policy;
+    if (!policy._ttl || SNMP_STREAM) {
+        return registration._provider->get(oid);
+    }
+    uint32_t now = millis();
+    uint32_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _cache.find(oid);
+        if (it != _cache.end()) {
+            Entry &entry = it->second;
+            generation = entry._generation;
+            uint32_t age = now - entry._time;
+            if (entry._value && (age < static_cast<uint64_t>(policy._ttl) + policy._maxStaleness)) {
+                // Refresh ahead of expiry, or right away if stale
+                if (!entry._refreshing && (static_cast<uint64_t>(age) + policy._refreshAhead >= policy._ttl)) {
+                    entry._refreshing = true;
+                    asio::post(_pool, [this, provider = registration._provider, oid, generation, policy]() {
+                        store(oid, fetch(*provider, oid), generation, policy);
+                    });
+                }
+                return new EncodedBER(entry._value);
+            }
+        }
+    }
+    // Missing, invalidated or too stale, fetch now
+    EncodedBER::Bytes value = fetch(*registration._provider, oid);
+    store(oid, value, generation, policy);
+    return value ? new EncodedBER(value) : nullptr;
+}
+
+// Fetch and encode a value from a provider
+EncodedBER::Bytes MIB::fetch(Provider &provider, const ObjectIdentifier &oid) {
+#if SNMP_STREAM
+    return nullptr;
+#else
+    BER *value = provider.get(oid);
+    if (!value) {
+        return nullptr;
+    }
+    auto encoded = std::make_shared<std::vector<uint8_t>>(value->getSize(true));
+    value->encode(encoded->data());
+    delete value;
+    return encoded;
+#endif
+}
+
+// Store a fetched value in the cache
+void MIB::store(const ObjectIdentifier &oid, const EncodedBER::Bytes &value, const uint32_t generation,
+        const CachePolicy &policy) {
+    const uint32_t now = millis();
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _cache.find(oid);
+    // A value fetched before an invalidation is stale, an entry never invalidated is generation 0
+    if ((it != _cache.end()) ? (it->second._generation == generation) : (generation == 0)) {
+        if (value) {
+            _cache[oid] = Entry { value, now, false, static_cast<uint64_t>(policy._ttl) + policy._maxStaleness,
+                    generation };
+        } else if (it != _cache.end()) {
+            // The instance is gone, the entry keeps its generation until it expires
+            it->second._value = nullptr;
+            it->second._refreshing = false;
+        }
+    }
+    // Purge expired entries once per second, instances of churning tables would accumulate
+    if (now - _purge >= 1000) {
+        _purge = now;
+        std::erase_if(_cache, [now](const auto &item) {
+            return now - item.second._time >= item.second._lifetime;
+        });
+    }
+}
+
+// Invalidate a cached value changed by a SET
+void MIB::invalidate(const ObjectIdentifier &oid, const CachePolicy &policy) {
+    if (!policy._ttl) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry &entry = _cache[oid];
+    entry._value = nullptr;
+    entry._time = millis();
+    entry._refreshing = false;
+    entry._lifetime = static_cast<uint64_t>(policy._ttl) + policy._maxStaleness;
+    entry._generation++;
+}
+
+} // namespace SNMP
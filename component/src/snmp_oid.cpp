@@ -0,0 +1,424 @@
+#include "snmp_oid.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SNMP_OID_SIMD 1
+#include <immintrin.h>
+#else
+#define SNMP_OID_SIMD 0
+#endif
+
+namespace SNMP {
+
+namespace {
+
+/** Count returned by a decoder for malformed subidentifiers. */
+constexpr size_t INVALID = SIZE_MAX;
+
+/**
+ * @struct Partial
+ * @brief Arc being decoded, possibly spanning chunks.
+ */
+struct Partial {
+    /** Bits decoded so far. */
+    uint64_t _value = 0;
+    /** Bytes decoded so far. */
+    uint8_t _size = 0;
+
+    // Add a byte, storing the arc on its last byte
+    inline bool add(const uint8_t byte, uint32_t *arcs, size_t &count) {
+        _value = (_value << 7) | (byte & 0x7F);
+        if (++_size > 5) {
+            return false;
+        }
+        if (byte & 0x80) {
+            return true;
+        }
+        if (_value > UINT32_MAX) {
+            return false;
+        }
+        arcs[count++] = _value;
+        _value = 0;
+        _size = 0;
+        return true;
+    }
+};
+
+// Decode subidentifiers one byte at a time
+size_t decodeScalar(const uint8_t *data, const size_t length, uint32_t *arcs) {
+    Partial partial;
+    size_t count = 0;
+    for (size_t position = 0; position < length; ++position) {
+        if (!partial.add(data[position], arcs, count)) {
+            return INVALID;
+        }
+    }
+    return partial._size ? INVALID : count;
+}
+
+#if SNMP_OID_SIMD
+// Decode the arcs of a chunk, given the mask of the last bytes of arcs
+inline bool walk(const uint8_t *chunk, const unsigned width, uint64_t ends, Partial &partial, uint32_t *arcs,
+        size_t &count) {
+    unsigned start = 0;
+    while (ends) {
+        const unsigned end = std::countr_zero(ends);
+        ends &= ends - 1;
+        if (!partial._size && (end == start)) {
+            arcs[count++] = chunk[end];
+        } else {
+            for (unsigned index = start; index <= end; ++index) {
+                if (!partial.add(chunk[index], arcs, count)) {
+                    return false;
+                }
+            }
+        }
+        start = end + 1;
+    }
+    // Bytes of an arc continued in the next chunk
+    for (unsigned index = start; index < width; ++index) {
+        if (!partial.add(chunk[index], arcs, count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decode subidentifiers 16 bytes at a time
+__attribute__((target("sse4.1")))
+size_t decodeSSE41(const uint8_t *data, const size_t length, uint32_t *arcs) {
+    Partial partial;
+    size_t count = 0;
+    size_t position = 0;
+    for (; position + 16 <= length; position += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+        const uint32_t continuation = _mm_movemask_epi8(chunk);
+        if (!continuation && !partial._size) {
+            // 16 single byte arcs, widened to 32 bits
+            __m128i *output = reinterpret_cast<__m128i*>(arcs + count);
+            _mm_storeu_si128(output, _mm_cvtepu8_epi32(chunk));
+            _mm_storeu_si128(output + 1, _mm_cvtepu8_epi32(_mm_srli_si128(chunk, 4)));
+            _mm_storeu_si128(output + 2, _mm_cvtepu8_epi32(_mm_srli_si128(chunk, 8)));
+            _mm_storeu_si128(output + 3, _mm_cvtepu8_epi32(_mm_srli_si128(chunk, 12)));
+            count += 16;
+        } else if (!walk(data + position, 16, ~continuation & 0xFFFF, partial, arcs, count)) {
+            return INVALID;
+        }
+    }
+    for (; position < length; ++position) {
+        if (!partial.add(data[position], arcs, count)) {
+            return INVALID;
+        }
+    }
+    return partial._size ? INVALID : count;
+}
+
+// Decode subidentifiers 32 bytes at a time
+__attribute__((target("avx2")))
+size_t decodeAVX2(const uint8_t *data, const size_t length, uint32_t *arcs) {
+    Partial partial;
+    size_t count = 0;
+    size_t position = 0;
+    for (; position + 32 <= length; position += 32) {
+        const uint8_t *pointer = data + position;
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer));
+        const uint32_t continuation = _mm256_movemask_epi8(chunk);
+        if (!continuation && !partial._size) {
+            // 32 single byte arcs, widened to 32 bits
+            __m256i *output = reinterpret_cast<__m256i*>(arcs + count);
+            for (unsigned index = 0; index < 4; ++index) {
+                const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pointer + 8 * index));
+                _mm256_storeu_si256(output + index, _mm256_cvtepu8_epi32(bytes));
+            }
+            count += 32;
+        } else if (!walk(pointer, 32, ~continuation, partial, arcs, count)) {
+            return INVALID;
+        }
+    }
+    for (; position < length; ++position) {
+        if (!partial.add(data[position], arcs, count)) {
+            return INVALID;
+        }
+    }
+    return partial._size ? INVALID : count;
+}
+#endif
+
+/** Subidentifiers decoder. */
+using Decoder = size_t (*)(const uint8_t *data, const size_t length, uint32_t *arcs);
+
+// Select the decoder of the CPU
+Decoder selectDecoder() {
+#if SNMP_OID_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return decodeAVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return decodeSSE41;
+    }
+#endif
+    return decodeScalar;
+}
+
+// Get the count of bytes of a base-128 subidentifier
+inline size_t subidentifierSize(uint64_t value) {
+    size_t size = 1;
+    while (value >>= 7) {
+        size++;
+    }
+    return size;
+}
+
+// Encode a base-128 subidentifier
+inline uint8_t* encodeSubidentifier(uint8_t *pointer, const uint64_t value) {
+    if (value < 0x80) {
+        *pointer++ = value;
+        return pointer;
+    }
+    for (size_t index = subidentifierSize(value); index > 0; --index) {
+        *pointer++ = ((value >> (7 * (index - 1))) & 0x7F) | ((index > 1) ? 0x80 : 0x00);
+    }
+    return pointer;
+}
+
+// Encode arcs one at a time
+uint8_t* encodeScalar(const uint32_t *arcs, const size_t count, uint8_t *pointer) {
+    for (size_t index = 0; index < count; ++index) {
+        pointer = encodeSubidentifier(pointer, arcs[index]);
+    }
+    return pointer;
+}
+
+#if SNMP_OID_SIMD
+// Encode arcs, runs of 16 single byte arcs narrowed at once
+__attribute__((target("sse4.1")))
+uint8_t* encodeSSE41(const uint32_t *arcs, const size_t count, uint8_t *pointer) {
+    const __m128i large = _mm_set1_epi32(~0x7F);
+    size_t index = 0;
+    while (index + 16 <= count) {
+        const __m128i *input = reinterpret_cast<const __m128i*>(arcs + index);
+        const __m128i first = _mm_loadu_si128(input);
+        const __m128i second = _mm_loadu_si128(input + 1);
+        const __m128i third = _mm_loadu_si128(input + 2);
+        const __m128i fourth = _mm_loadu_si128(input + 3);
+        const __m128i all = _mm_or_si128(_mm_or_si128(first, second), _mm_or_si128(third, fourth));
+        if (_mm_testz_si128(all, large)) {
+            const __m128i words = _mm_packus_epi32(first, second);
+            const __m128i bytes = _mm_packus_epi16(words, _mm_packus_epi32(third, fourth));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pointer), bytes);
+            pointer += 16;
+        } else {
+            pointer = encodeScalar(arcs + index, 16, pointer);
+        }
+        index += 16;
+    }
+    return encodeScalar(arcs + index, count - index, pointer);
+}
+#endif
+
+/** Arcs encoder. */
+using Encoder = uint8_t* (*)(const uint32_t *arcs, const size_t count, uint8_t *pointer);
+
+// Select the encoder of the CPU
+Encoder selectEncoder() {
+#if SNMP_OID_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) {
+        return encodeSSE41;
+    }
+#endif
+    return encodeScalar;
+}
+
+// Get the decoder selected on first use
+inline Decoder decoder() {
+    static const Decoder selected = selectDecoder();
+    return selected;
+}
+
+// Get the encoder selected on first use
+inline Encoder encoder() {
+    static const Encoder selected = selectEncoder();
+    return selected;
+}
+
+// Get the first subidentifier, the first two arcs combined
+inline uint64_t firstSubidentifier(const std::vector<uint32_t> &arcs) {
+    if (arcs.empty()) {
+        return 0;
+    }
+    return arcs[0] * 40ULL + ((arcs.size() > 1) ? arcs[1] : 0);
+}
+
+// Get the position of the first differing byte, or length if none
+inline size_t mismatch(const uint8_t *a, const uint8_t *b, const size_t length) {
+    size_t position = 0;
+    for (; position + 8 <= length; position += 8) {
+        uint64_t wordA;
+        uint64_t wordB;
+        memcpy(&wordA, a + position, sizeof(wordA));
+        memcpy(&wordB, b + position, sizeof(wordB));
+        if (const uint64_t difference = wordA ^ wordB) {
+            if constexpr (std::endian::native == std::endian::little) {
+                return position + (std::countr_zero(difference) >> 3);
+            } else {
+                return position + (std::countl_zero(difference) >> 3);
+            }
+        }
+    }
+    while ((position < length) && (a[position] == b[position])) {
+        position++;
+    }
+    return position;
+}
+
+// Get the position following the last byte of the subidentifier at a position
+inline size_t subidentifierEnd(const uint8_t *data, const size_t length, size_t position) {
+    while ((position < length) && (data[position] & 0x80)) {
+        position++;
+    }
+    return (position < length) ? position + 1 : length;
+}
+
+} // namespace
+
+// Parse a dotted string
+bool ObjectIdentifier::parse(const char *oid) {
+    _arcs.clear();
+    if (!oid) {
+        return false;
+    }
+    if (*oid == '.') {
+        oid++;
+    }
+    while (*oid) {
+        if ((*oid < '0') || (*oid > '9')) {
+            _arcs.clear();
+            return false;
+        }
+        uint64_t arc = 0;
+        while ((*oid >= '0') && (*oid <= '9')) {
+            arc = arc * 10 + (*oid++ - '0');
+            if (arc > UINT32_MAX) {
+                _arcs.clear();
+                return false;
+            }
+        }
+        _arcs.push_back(arc);
+        if (*oid == '.') {
+            if (!*++oid) {
+                _arcs.clear();
+                return false;
+            }
+        } else if (*oid) {
+            _arcs.clear();
+            return false;
+        }
+    }
+    return !_arcs.empty();
+}
+
+// Convert to a dotted string
+std::string ObjectIdentifier::toString() const {
+    std::string oid;
+    oid.reserve(_arcs.size() * 4);
+    for (size_t index = 0; index < _arcs.size(); ++index) {
+        if (index) {
+            oid += '.';
+        }
+        oid += std::to_string(_arcs[index]);
+    }
+    return oid;
+}
+
+// Compare the contents of two BER encoded OIDs
+std::strong_ordering ObjectIdentifier::compare(const uint8_t *a, const size_t lengthA, const uint8_t *b,
+        const size_t lengthB) {
+    const size_t position = mismatch(a, b, std::min(lengthA, lengthB));
+    if ((position == lengthA) || (position == lengthB)) {
+        return lengthA <=> lengthB;
+    }
+    // Bytes before are equal, so the arcs containing the difference start together
+    const size_t endA = subidentifierEnd(a, lengthA, position);
+    const size_t endB = subidentifierEnd(b, lengthB, position);
+    if (endA != endB) {
+        return endA <=> endB;
+    }
+    return a[position] <=> b[position];
+}
+
+// Check if the content of a BER encoded OID is in a subtree
+bool ObjectIdentifier::startsWith(const uint8_t *data, const size_t length, const uint8_t *prefix,
+        const size_t prefixLength) {
+    // The prefix must end on an arc, which the OID then ends on too
+    return (prefixLength <= length) && (!prefixLength || !(prefix[prefixLength - 1] & 0x80))
+            && (mismatch(data, prefix, prefixLength) == prefixLength);
+}
+
+// Check if the OID is in a subtree
+bool ObjectIdentifier::startsWith(const ObjectIdentifier &prefix) const {
+    if (prefix._arcs.size() > _arcs.size()) {
+        return false;
+    }
+    for (size_t index = 0; index < prefix._arcs.size(); ++index) {
+        if (_arcs[index] != prefix._arcs[index]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decode the content of a BER encoded OID
+bool ObjectIdentifier::decode(const uint8_t *data, const size_t length) {
+    _arcs.clear();
+    // First subidentifier, up to 2.4294967295 so 5 bytes
+    uint64_t first = 0;
+    size_t position = 0;
+    uint8_t byte;
+    do {
+        if ((position == length) || (position == 5)) {
+            return false;
+        }
+        byte = data[position++];
+        first = (first << 7) | (byte & 0x7F);
+    } while (byte & 0x80);
+    const uint32_t arc = (first < 80) ? first / 40 : 2;
+    if (first - arc * 40 > UINT32_MAX) {
+        return false;
+    }
+
+    // An arc takes at least a byte
+    _arcs.resize(2 + length - position);
+    const size_t count = decoder()(data + position, length - position, _arcs.data() + 2);
+    if (count == INVALID) {
+        _arcs.clear();
+        return false;
+    }
+    _arcs[0] = arc;
+    _arcs[1] = first - arc * 40;
+    _arcs.resize(2 + count);
+    return true;
+}
+
+// Get the size of the BER encoded content
+size_t ObjectIdentifier::getLength() const {
+    size_t length = subidentifierSize(firstSubidentifier(_arcs));
+    for (size_t index = 2; index < _arcs.size(); ++index) {
+        length += subidentifierSize(_arcs[index]);
+    }
+    return length;
+}
+
+// Encode the content of a BER encoded OID
+uint8_t* ObjectIdentifier::encode(uint8_t *buffer) const {
+    uint8_t *pointer = encodeSubidentifier(buffer, firstSubidentifier(_arcs));
+    if (_arcs.size() > 2) {
+        pointer = encoder()(_arcs.data() + 2, _arcs.size() - 2, pointer);
+    }
+    return pointer;
+}
+
+} // namespace SNMP
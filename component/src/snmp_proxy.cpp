@@ -0,0 +1,241 @@
+#include "snmp_proxy.h"
+#include <chrono>
+
+#if !SNMP_STREAM
+namespace SNMP {
+
+namespace {
+
+// Encodes a value, shared by the responses and the cache
+EncodedBER::Bytes encode(BER *value) {
+    auto encoded = std::make_shared<std::vector<uint8_t>>(value->getSize(true));
+    value->encode(encoded->data());
+    return encoded;
+}
+
+// Checks if a request type is answered from the cache
+inline bool cacheable(const uint8_t type) {
+    return (type == Type::GetRequest) || (type == Type::GetNextRequest);
+}
+
+} // namespace
+
+// Proxy constructor
+Proxy::Proxy(asio::io_context &io_context, std::shared_ptr<Manager> manager, const uint32_t ttl,
+        const uint32_t timeout) :
+        _io_context(io_context), _manager(std::move(manager)), _ttl(ttl), _timeout(timeout) {
+}
+
+// Create a proxy handling the responses of a manager
+std::shared_ptr<Proxy> Proxy::create(asio::io_context &io_context, std::shared_ptr<Manager> manager,
+        const uint32_t ttl, const uint32_t timeout) {
+    auto proxy = std::make_shared<Proxy>(io_context, manager, ttl, timeout);
+    std::weak_ptr<Proxy> weak = proxy;
+    manager->onMessage([weak](const Message *message, const IPAddress remote, const uint16_t port) {
+        auto proxy = weak.lock();
+        if (proxy) {
+            proxy->receive(message, remote, port);
+        }
+    });
+    return proxy;
+}
+
+// Add a target agent
+bool Proxy::add(const char *community, const IPAddress &address, const uint16_t port, const char *upstream) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!community || _communities.count(community)) {
+        return false;
+    }
+    _communities[community] = _targets.size();
+    _targets.push_back(Target { address, port, upstream ? upstream : "" });
+    return true;
+}
+
+// Forward a request to its target, or respond from the cache
+void Proxy::forward(std::shared_ptr<Request> request) {
+    const Message *message = request->getMessage();
+    const uint8_t type = message->getType();
+    if ((type != Type::GetRequest) && (type != Type::GetNextRequest) && (type != Type::GetBulkRequest)
+            && (type != Type::SetRequest)) {
+        request->respond(nullptr);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto community = _communities.find(message->getCommunity());
+    if (community == _communities.end()) {
+        request->respond(nullptr);
+        return;
+    }
+    const size_t target = community->second;
+    if (cacheable(type) && respond(request, target)) {
+        return;
+    }
+
+    // Identical requests share the forwarded one, SETs are never coalesced
+    VarBindList *list = message->getVarBindList();
+    std::string key;
+    if (type != Type::SetRequest) {
+        key = std::to_string(target) + ' ' + std::to_string(message->getVersion()) + ' ' + std::to_string(type);
+        if (type == Type::GetBulkRequest) {
+            key += ' ' + std::to_string(message->getNonRepeaters()) + ' ' + std::to_string(message->getMaxRepetition());
+        }
+        for (uint32_t index = 0; index < list->count(); ++index) {
+            key += ' ';
+            key += (*list)[index]->getName();
+        }
+        auto it = _coalesced.find(key);
+        if (it != _coalesced.end()) {
+            it->second->_requests.push_back(request);
+            return;
+        }
+    }
+
+    const Target &destination = _targets[target];
+    const int32_t id = static_cast<int32_t>(++_requestID);
+    Message upstream(message->getVersion(),
+            destination._community.empty() ? message->getCommunity() : destination._community.c_str(), type);
+    upstream.setRequestID(id);
+    if (type == Type::GetBulkRequest) {
+        upstream.setNonRepeaters(message->getNonRepeaters());
+        upstream.setMaxRepetitions(message->getMaxRepetition());
+    }
+    for (uint32_t index = 0; index < list->count(); ++index) {
+        VarBind *varbind = (*list)[index];
+        BER *value = varbind->getValue();
+        upstream.add(varbind->getName(), (type == Type::SetRequest) && value ? new EncodedBER(encode(value)) : nullptr);
+    }
+
+    auto flight = std::make_shared<Flight>(Flight { key, target, { request }, asio::steady_timer(_io_context) });
+    _flights[id] = flight;
+    if (!key.empty()) {
+        _coalesced[key] = flight;
+    }
+    flight->_timer.expires_after(std::chrono::milliseconds(_timeout));
+    flight->_timer.async_wait([weak = weak_from_this(), id](const asio::error_code &error) {
+        auto proxy = weak.lock();
+        if (!error && proxy) {
+            proxy->expire(id);
+        }
+    });
+    _manager->send(&upstream, destination._address, destination._port);
+}
+
+// Handle a message received by the manager
+void Proxy::receive(const Message *message, const IPAddress remote, const uint16_t port) {
+    if (message->getType() != Type::GetResponse) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto it = _flights.find(message->getRequestID());
+    if (it == _flights.end()) {
+        return;
+    }
+    std::shared_ptr<Flight> flight = it->second;
+    const Target &target = _targets[flight->_target];
+    if ((remote != target._address) || (port != target._port)) {
+        return;
+    }
+    _flights.erase(it);
+    if (!flight->_key.empty()) {
+        _coalesced.erase(flight->_key);
+    }
+    flight->_timer.cancel();
+
+    // Values are encoded once for all the responses
+    VarBindList *list = message->getVarBindList();
+    const uint32_t count = list->count();
+    std::vector<EncodedBER::Bytes> values(count);
+    for (uint32_t index = 0; index < count; ++index) {
+        BER *value = (*list)[index]->getValue();
+        if (value) {
+            values[index] = encode(value);
+        }
+    }
+
+    const Message *forwarded = flight->_requests[0]->getMessage();
+    const uint8_t version = forwarded->getVersion();
+    const uint8_t type = forwarded->getType();
+    VarBindList *requested = forwarded->getVarBindList();
+    const uint32_t now = millis();
+    if ((message->getErrorStatus() == Error::NoError) && (requested->count() == count)) {
+        for (uint32_t index = 0; index < count; ++index) {
+            ObjectIdentifier oid((*requested)[index]->getName());
+            if (type == Type::SetRequest) {
+                // Entries of any version holding the value, read by a GET or as the next instance
+                const std::string name = oid.toString();
+                std::erase_if(_cache, [&flight, &oid, &name](const auto &item) {
+                    const Key &key = item.first;
+                    return (std::get<0>(key) == flight->_target)
+                            && (((std::get<2>(key) == Type::GetRequest) && (std::get<3>(key) == oid))
+                                    || ((std::get<2>(key) == Type::GetNextRequest) && (item.second._name == name)));
+                });
+            } else if (_ttl && cacheable(type) && values[index]) {
+                _cache[Key { flight->_target, version, type, oid }] = Entry { (*list)[index]->getName(),
+                        values[index], now };
+            }
+        }
+    }
+    // Purge expired entries once per TTL
+    if (now - _purge >= _ttl) {
+        _purge = now;
+        std::erase_if(_cache, [this, now](const auto &item) {
+            return now - item.second._time >= _ttl;
+        });
+    }
+    lock.unlock();
+
+    for (std::shared_ptr<Request> &request : flight->_requests) {
+        auto response = request->createResponse();
+        for (uint32_t index = 0; index < count; ++index) {
+            response->add((*list)[index]->getName(), values[index] ? new EncodedBER(values[index]) : nullptr);
+        }
+        response->setError(message->getErrorStatus(), message->getErrorIndex());
+        request->respond(std::move(response));
+    }
+}
+
+// Respond to a request from the cache
+bool Proxy::respond(const std::shared_ptr<Request> &request, const size_t target) {
+    if (!_ttl) {
+        return false;
+    }
+    const Message *message = request->getMessage();
+    const uint8_t type = message->getType();
+    VarBindList *list = message->getVarBindList();
+    const uint32_t now = millis();
+    std::vector<const Entry*> entries(list->count());
+    for (uint32_t index = 0; index < list->count(); ++index) {
+        auto it = _cache.find(Key { target, message->getVersion(), type, ObjectIdentifier((*list)[index]->getName()) });
+        if ((it == _cache.end()) || (now - it->second._time >= _ttl)) {
+            return false;
+        }
+        entries[index] = &it->second;
+    }
+    auto response = request->createResponse();
+    for (const Entry *entry : entries) {
+        response->add(entry->_name.c_str(), new EncodedBER(entry->_value));
+    }
+    request->respond(std::move(response));
+    return true;
+}
+
+// Drop a forwarded request after its timeout
+void Proxy::expire(const int32_t id) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto it = _flights.find(id);
+    if (it == _flights.end()) {
+        return;
+    }
+    std::shared_ptr<Flight> flight = it->second;
+    _flights.erase(it);
+    if (!flight->_key.empty()) {
+        _coalesced.erase(flight->_key);
+    }
+    lock.unlock();
+    for (std::shared_ptr<Request> &request : flight->_requests) {
+        request->respond(nullptr);
+    }
+}
+
+} // namespace SNMP
+#endif
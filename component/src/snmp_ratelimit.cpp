@@ -0,0 +1,94 @@
+#include "snmp_ratelimit.h"
+#include "arduino_compat.h"
+#include <cstring>
+
+namespace SNMP {
+
+// Rate limiter constructor
+RateLimiter::RateLimiter(size_t sets) {
+    size_t count = 1;
+    while (count < sets) {
+        count <<= 1;
+    }
+    _sets.resize(count);
+    _mask = count - 1;
+    reset();
+}
+
+// Set rate and burst
+void RateLimiter::setRate(const uint32_t rate, const uint32_t burst) {
+    _rate = rate;
+    uint64_t capacity = static_cast<uint64_t>(burst ? burst : 1) * TOKEN;
+    _capacity = capacity > UINT32_MAX ? UINT32_MAX : capacity;
+    reset();
+}
+
+// Reset all buckets
+void RateLimiter::reset() {
+    memset(static_cast<void*>(_sets.data()), 0, _sets.size() * sizeof(Set));
+}
+
+// Compute the key of a source address
+uint64_t RateLimiter::key(const IPAddress &address) {
+    if (!address.isV6()) {
+        return (1ULL << 32) | static_cast<uint32_t>(address);
+    }
+    // FNV-1a, top bit set to keep IPv6 keys apart from IPv4 keys
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (uint8_t index = 0; index < 16; ++index) {
+        hash = (hash ^ address[index]) * 0x100000001B3ULL;
+    }
+    return hash | (1ULL << 63);
+}
+
+// Check and consume a token from the source bucket
+bool RateLimiter::allow(const IPAddress &address, const uint32_t now) {
+    if (!_rate) {
+        return true;
+    }
+    uint64_t key = RateLimiter::key(address);
+    uint64_t hash = key * 0x9E3779B97F4A7C15ULL;
+    Set &set = _sets[(hash >> 32) & _mask];
+
+    // Find the source bucket, or the least recently seen one
+    Bucket *bucket = nullptr;
+    Bucket *oldest = &set._buckets[0];
+    for (uint8_t index = 0; index < WAYS; ++index) {
+        Bucket &candidate = set._buckets[index];
+        if (candidate._key == key) {
+            bucket = &candidate;
+            break;
+        }
+        if (!candidate._key) {
+            oldest = &candidate;
+        } else if (oldest->_key && now - candidate._time > now - oldest->_time) {
+            oldest = &candidate;
+        }
+    }
+    if (!bucket) {
+        bucket = oldest;
+        bucket->_key = key;
+        bucket->_tokens = _capacity;
+        bucket->_time = now;
+    }
+
+    // Refill
+    uint64_t tokens = bucket->_tokens + static_cast<uint64_t>(now - bucket->_time) * _rate;
+    bucket->_tokens = tokens > _capacity ? _capacity : tokens;
+    bucket->_time = now;
+
+    // Consume
+    if (bucket->_tokens < TOKEN) {
+        _dropped++;
+        return false;
+    }
+    bucket->_tokens -= TOKEN;
+    return true;
+}
+
+// Check a source with the current time
+bool RateLimiter::allow(const IPAddress &address) {
+    return allow(address, millis());
+}
+
+} // namespace SNMP
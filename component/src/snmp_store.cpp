@@ -0,0 +1,525 @@
+#include "snmp_store.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#ifndef ESP_PLATFORM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !SNMP_STREAM
+namespace SNMP {
+
+namespace {
+
+// Snapshot file magic and version
+constexpr char MAGIC[4] = { 'S', 'N', 'A', 'P' };
+constexpr uint32_t ORDER = 0x01020304;
+constexpr uint32_t VERSION = 1;
+// File header: magic, byte order mark, version
+constexpr size_t FILE_HEADER = 12;
+// Frame header: kind, count of records, size of the records
+constexpr size_t FRAME_HEADER = 12;
+// Frame trailer: CRC-32 of the header and the records
+constexpr size_t FRAME_TRAILER = 4;
+
+// Kinds of frames
+enum Kind : uint32_t {
+    Full,
+    Delta
+};
+
+// CRC-32 table, IEEE polynomial
+struct CRC32 {
+    uint32_t _table[256];
+
+    constexpr CRC32() :
+            _table() {
+        for (uint32_t index = 0; index < 256; ++index) {
+            uint32_t crc = index;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            }
+            _table[index] = crc;
+        }
+    }
+
+    uint32_t operator()(const uint8_t *data, const size_t size) const {
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t index = 0; index < size; ++index) {
+            crc = _table[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+};
+
+constexpr CRC32 crc32;
+
+// Append a 32-bit integer
+inline void append32(std::vector<uint8_t> &buffer, const uint32_t value) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+// Read a 32-bit integer
+inline uint32_t read32(const uint8_t *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Frame of records being built
+class Frame {
+public:
+    Frame(const Kind kind) {
+        append32(_buffer, kind);
+        append32(_buffer, 0);
+        append32(_buffer, 0);
+    }
+
+    // Add a record, a null value removes the instance
+    void add(const ObjectIdentifier &oid, const EncodedBER::Bytes &value) {
+        append32(_buffer, oid.size());
+        const uint8_t *arcs = reinterpret_cast<const uint8_t*>(oid.data());
+        _buffer.insert(_buffer.end(), arcs, arcs + oid.size() * sizeof(uint32_t));
+        append32(_buffer, value ? value->size() : 0);
+        if (value) {
+            _buffer.insert(_buffer.end(), value->begin(), value->end());
+        }
+        _count++;
+    }
+
+    uint32_t count() const {
+        return _count;
+    }
+
+    // Complete the header and the trailer
+    const std::vector<uint8_t>& finish() {
+        const uint32_t size = _buffer.size() - FRAME_HEADER;
+        memcpy(_buffer.data() + 4, &_count, sizeof(_count));
+        memcpy(_buffer.data() + 8, &size, sizeof(size));
+        append32(_buffer, crc32(_buffer.data(), _buffer.size()));
+        return _buffer;
+    }
+
+private:
+    std::vector<uint8_t> _buffer;
+    uint32_t _count = 0;
+};
+
+// Parse the records of a checked frame
+bool parse(const uint8_t *data, const size_t size, const uint32_t count, std::vector<Store::Update::Change> &changes) {
+    size_t offset = 0;
+    for (uint32_t index = 0; index < count; ++index) {
+        if (size - offset < 4) {
+            return false;
+        }
+        const uint32_t arcs = read32(data + offset);
+        offset += 4;
+        if ((arcs == 0) || ((size - offset) / sizeof(uint32_t) < arcs)) {
+            return false;
+        }
+        ObjectIdentifier oid;
+        for (uint32_t arc = 0; arc < arcs; ++arc, offset += 4) {
+            oid.append(read32(data + offset));
+        }
+        if (size - offset < 4) {
+            return false;
+        }
+        const uint32_t length = read32(data + offset);
+        offset += 4;
+        if (size - offset < length) {
+            return false;
+        }
+        EncodedBER::Bytes value;
+        if (length) {
+            value = std::make_shared<const std::vector<uint8_t>>(data + offset, data + offset + length);
+            offset += length;
+        }
+        changes.push_back(Store::Update::Change { std::move(oid), std::move(value) });
+    }
+    return offset == size;
+}
+
+// Write a file, appended or written aside and renamed
+bool writeFile(const std::string &path, const std::vector<uint8_t> &header, const std::vector<uint8_t> &frame,
+        const bool append) {
+    const std::string target = append ? path : path + ".tmp";
+    FILE *file = fopen(target.c_str(), append ? "ab" : "wb");
+    if (!file) {
+        return false;
+    }
+    bool success = (fwrite(header.data(), 1, header.size(), file) == header.size())
+            && (fwrite(frame.data(), 1, frame.size(), file) == frame.size());
+    success = (fflush(file) == 0) && success;
+#ifndef ESP_PLATFORM
+    success = (fsync(fileno(file)) == 0) && success;
+#endif
+    success = (fclose(file) == 0) && success;
+    if (!append) {
+        success = success && (rename(target.c_str(), path.c_str()) == 0);
+    }
+    return success;
+}
+
+// File header
+std::vector<uint8_t> header() {
+    std::vector<uint8_t> header(MAGIC, MAGIC + sizeof(MAGIC));
+    append32(header, ORDER);
+    append32(header, VERSION);
+    return header;
+}
+
+// Sort changes by OID, keeping the last change of each instance
+void normalize(std::vector<Store::Update::Change> &changes) {
+    std::stable_sort(changes.begin(), changes.end(), [](const Store::Update::Change &a, const Store::Update::Change &b) {
+        return a._oid < b._oid;
+    });
+    size_t kept = 0;
+    for (size_t index = 0; index < changes.size(); ++index) {
+        if ((index + 1 < changes.size()) && (changes[index + 1]._oid == changes[index]._oid)) {
+            continue;
+        }
+        if (kept++ != index) {
+            changes[kept - 1] = std::move(changes[index]);
+        }
+    }
+    changes.resize(kept);
+}
+
+} // namespace
+
+// Set the value of an instance
+void Store::Update::set(const ObjectIdentifier &oid, BER *value) {
+    auto encoded = std::make_shared<std::vector<uint8_t>>(value->getSize(true));
+    value->encode(encoded->data());
+    delete value;
+    _changes.push_back(Change { oid, std::move(encoded) });
+}
+
+// Remove an instance
+void Store::Update::remove(const ObjectIdentifier &oid) {
+    _changes.push_back(Change { oid, nullptr });
+}
+
+// Store constructor
+Store::Store() :
+        _current(new Snapshot { std::make_shared<const std::vector<ObjectIdentifier>>(), { } }) {
+}
+
+// Store destructor
+Store::~Store() {
+    delete _current.load();
+}
+
+// Apply and publish an update
+void Store::apply(Update &update) {
+    std::vector<Update::Change> &changes = update._changes;
+    if (changes.empty()) {
+        return;
+    }
+    normalize(changes);
+    publish(changes, false);
+    changes.clear();
+}
+
+// Publish sorted changes
+void Store::publish(std::vector<Update::Change> &changes, const bool reset) {
+    static const std::vector<ObjectIdentifier> noNames;
+    static const std::vector<EncodedBER::Bytes> noValues;
+    std::lock_guard<std::mutex> lock(_mutex);
+    // Writers are serialized, the current snapshot can't be retired meanwhile
+    const Snapshot *current = _current.load();
+    const std::vector<ObjectIdentifier> &names = reset ? noNames : *current->_names;
+    const std::vector<EncodedBER::Bytes> &values = reset ? noValues : current->_values;
+    std::vector<size_t> positions;
+    positions.reserve(changes.size());
+    auto from = names.begin();
+    for (const Update::Change &change : changes) {
+        from = std::lower_bound(from, names.end(), change._oid);
+        if ((from == names.end()) || !(*from == change._oid) || !change._value) {
+            break;
+        }
+        positions.push_back(from - names.begin());
+    }
+
+    auto snapshot = new Snapshot;
+    if (!reset && (positions.size() == changes.size())) {
+        // Values of existing instances only, share the names
+        snapshot->_names = current->_names;
+        snapshot->_values = values;
+        for (size_t index = 0; index < changes.size(); ++index) {
+            snapshot->_values[positions[index]] = std::move(changes[index]._value);
+        }
+    } else {
+        // Merge the sorted changes into the sorted instances
+        auto merged = std::make_shared<std::vector<ObjectIdentifier>>();
+        merged->reserve(names.size() + changes.size());
+        snapshot->_values.reserve(names.size() + changes.size());
+        size_t position = 0;
+        for (Update::Change &change : changes) {
+            for (; (position < names.size()) && (names[position] < change._oid); ++position) {
+                merged->push_back(names[position]);
+                snapshot->_values.push_back(values[position]);
+            }
+            if ((position < names.size()) && (names[position] == change._oid)) {
+                position++;
+            }
+            if (change._value) {
+                merged->push_back(std::move(change._oid));
+                snapshot->_values.push_back(std::move(change._value));
+            }
+        }
+        for (; position < names.size(); ++position) {
+            merged->push_back(names[position]);
+            snapshot->_values.push_back(values[position]);
+        }
+        snapshot->_names = std::move(merged);
+    }
+    _current.store(snapshot);
+    _epoch.retire(current);
+}
+
+// Set and publish the value of an instance
+void Store::set(const ObjectIdentifier &oid, BER *value) {
+    Update update;
+    update.set(oid, value);
+    apply(update);
+}
+
+// Remove and publish an instance
+void Store::remove(const ObjectIdentifier &oid) {
+    Update update;
+    update.remove(oid);
+    apply(update);
+}
+
+// Get the count of instances
+size_t Store::size() {
+    Epoch::Guard guard(_epoch);
+    return _current.load()->_values.size();
+}
+
+// Save all instances to a snapshot file
+bool Store::save(const char *path) {
+    std::shared_ptr<const std::vector<ObjectIdentifier>> names;
+    std::vector<EncodedBER::Bytes> values;
+    capture(names, values);
+    Frame frame(Full);
+    for (size_t index = 0; index < names->size(); ++index) {
+        frame.add((*names)[index], values[index]);
+    }
+    return writeFile(path, header(), frame.finish(), false);
+}
+
+// Restore the instances of a snapshot file
+bool Store::restore(const char *path) {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+#ifdef ESP_PLATFORM
+    std::vector<uint8_t> buffer;
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    uint8_t chunk[512];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + read);
+    }
+    fclose(file);
+    data = buffer.data();
+    size = buffer.size();
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if ((fstat(fd, &status) != 0) || (static_cast<size_t>(status.st_size) < FILE_HEADER)) {
+        close(fd);
+        return false;
+    }
+    size = status.st_size;
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    std::unique_ptr<void, std::function<void(void*)>> mapping(map, [size](void *map) {
+        munmap(map, size);
+    });
+    data = static_cast<const uint8_t*>(map);
+#endif
+    if ((size < FILE_HEADER) || (memcmp(data, MAGIC, sizeof(MAGIC)) != 0) || (read32(data + 4) != ORDER)
+            || (read32(data + 8) != VERSION)) {
+        return false;
+    }
+
+    std::vector<Update::Change> changes;
+    bool reset = false;
+    bool restored = false;
+    for (size_t offset = FILE_HEADER; size - offset >= FRAME_HEADER + FRAME_TRAILER;) {
+        const uint8_t *frame = data + offset;
+        const uint32_t kind = read32(frame);
+        const uint32_t length = read32(frame + 8);
+        if ((length > size - offset - FRAME_HEADER - FRAME_TRAILER)
+                || (crc32(frame, FRAME_HEADER + length) != read32(frame + FRAME_HEADER + length))) {
+            break;
+        }
+        std::vector<Update::Change> records;
+        if (((kind != Full) && (kind != Delta)) || !parse(frame + FRAME_HEADER, length, read32(frame + 4), records)) {
+            break;
+        }
+        if (kind == Full) {
+            changes.clear();
+            reset = true;
+        }
+        std::move(records.begin(), records.end(), std::back_inserter(changes));
+        restored = true;
+        offset += FRAME_HEADER + length + FRAME_TRAILER;
+    }
+    if (!restored) {
+        return false;
+    }
+    normalize(changes);
+    publish(changes, reset);
+    return true;
+}
+
+// Get the instances of the current snapshot
+void Store::capture(std::shared_ptr<const std::vector<ObjectIdentifier>> &names,
+        std::vector<EncodedBER::Bytes> &values) {
+    Epoch::Guard guard(_epoch);
+    const Snapshot *snapshot = _current.load();
+    names = snapshot->_names;
+    values = snapshot->_values;
+}
+
+// Get the value of an instance
+BER* Store::get(const ObjectIdentifier &oid) {
+    Epoch::Guard guard(_epoch);
+    const Snapshot *snapshot = _current.load();
+    const std::vector<ObjectIdentifier> &names = *snapshot->_names;
+    auto it = std::lower_bound(names.begin(), names.end(), oid);
+    if ((it == names.end()) || !(*it == oid)) {
+        return nullptr;
+    }
+    return new EncodedBER(snapshot->_values[it - names.begin()]);
+}
+
+// Find the instance following an OID
+bool Store::next(const ObjectIdentifier &oid, ObjectIdentifier &next) {
+    Epoch::Guard guard(_epoch);
+    const std::vector<ObjectIdentifier> &names = *_current.load()->_names;
+    auto it = std::upper_bound(names.begin(), names.end(), oid);
+    if (it == names.end()) {
+        return false;
+    }
+    next = *it;
+    return true;
+}
+
+// Walk the instances following an OID
+size_t Store::walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances) {
+    Epoch::Guard guard(_epoch);
+    const Snapshot *snapshot = _current.load();
+    const std::vector<ObjectIdentifier> &names = *snapshot->_names;
+    size_t position = std::upper_bound(names.begin(), names.end(), oid) - names.begin();
+    const size_t end = position + std::min(count, names.size() - position);
+    for (size_t index = position; index < end; ++index) {
+        instances.push_back(Instance { names[index], new EncodedBER(snapshot->_values[index]) });
+    }
+    return end - position;
+}
+
+// StoreWriter constructor
+StoreWriter::StoreWriter(std::shared_ptr<Store> store, const char *path, const uint32_t period,
+        const uint32_t compaction) :
+        _store(store), _path(path), _period(period), _compaction(compaction), _pool(1), _timer(_pool) {
+    schedule();
+}
+
+// StoreWriter destructor
+StoreWriter::~StoreWriter() {
+    // Waits for a running write, the pending one is dropped
+    _pool.stop();
+    _pool.join();
+    write();
+}
+
+// Write the changes since the last write
+bool StoreWriter::write() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<const std::vector<ObjectIdentifier>> names;
+    std::vector<EncodedBER::Bytes> values;
+    _store->capture(names, values);
+
+    if (!_names || (_deltas >= _compaction)) {
+        Frame frame(Full);
+        for (size_t index = 0; index < names->size(); ++index) {
+            frame.add((*names)[index], values[index]);
+        }
+        if (!writeFile(_path, header(), frame.finish(), false)) {
+            return false;
+        }
+        _deltas = 0;
+    } else {
+        // Unchanged values are shared, compare pointers
+        Frame frame(Delta);
+        if (names == _names) {
+            for (size_t index = 0; index < values.size(); ++index) {
+                if (values[index] != _values[index]) {
+                    frame.add((*names)[index], values[index]);
+                }
+            }
+        } else {
+            const std::vector<ObjectIdentifier> &before = *_names;
+            const std::vector<ObjectIdentifier> &after = *names;
+            size_t old = 0;
+            size_t current = 0;
+            while ((old < before.size()) || (current < after.size())) {
+                if ((current == after.size()) || ((old < before.size()) && (before[old] < after[current]))) {
+                    frame.add(before[old++], nullptr);
+                } else if ((old == before.size()) || (after[current] < before[old])) {
+                    frame.add(after[current], values[current]);
+                    current++;
+                } else {
+                    if (values[current] != _values[old]) {
+                        frame.add(after[current], values[current]);
+                    }
+                    old++;
+                    current++;
+                }
+            }
+        }
+        if (!frame.count()) {
+            return true;
+        }
+        if (!writeFile(_path, { }, frame.finish(), true)) {
+            // Start over with a full frame
+            _names = nullptr;
+            return false;
+        }
+        _deltas++;
+    }
+    _names = std::move(names);
+    _values = std::move(values);
+    return true;
+}
+
+// Schedule the next write
+void StoreWriter::schedule() {
+    _timer.expires_after(std::chrono::milliseconds(_period));
+    _timer.async_wait([this](const asio::error_code &error) {
+        if (!error) {
+            write();
+            schedule();
+        }
+    });
+}
+
+} // namespace SNMP
+#endif
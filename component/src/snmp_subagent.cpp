@@ -0,0 +1,386 @@
+#include "snmp_subagent.h"
+#include <chrono>
+#include <cstring>
+#if !SNMP_STREAM && !defined(ESP_PLATFORM)
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace SNMP {
+
+namespace {
+
+using Socket = asio::local::stream_protocol::socket;
+
+// Append a 32-bit integer
+inline void append32(std::vector<uint8_t> &buffer, const uint32_t value) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+// Read a 32-bit integer, advancing the position
+inline bool read32(const std::vector<uint8_t> &buffer, size_t &position, uint32_t &value) {
+    if (buffer.size() - position < sizeof(value)) {
+        return false;
+    }
+    memcpy(&value, buffer.data() + position, sizeof(value));
+    position += sizeof(value);
+    return true;
+}
+
+// Append an OID, count of arcs then arcs
+void append(std::vector<uint8_t> &buffer, const ObjectIdentifier &oid) {
+    append32(buffer, oid.size());
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(oid.data());
+    buffer.insert(buffer.end(), bytes, bytes + oid.size() * sizeof(uint32_t));
+}
+
+// Read an OID, advancing the position
+bool read(const std::vector<uint8_t> &buffer, size_t &position, ObjectIdentifier &oid) {
+    uint32_t count = 0;
+    if (!read32(buffer, position, count) || (count > (buffer.size() - position) / sizeof(uint32_t))) {
+        return false;
+    }
+    uint32_t arc = 0;
+    for (uint32_t index = 0; index < count; ++index) {
+        read32(buffer, position, arc);
+        oid.append(arc);
+    }
+    return true;
+}
+
+// Set the size of a message, its first integer
+inline void seal(std::vector<uint8_t> &message) {
+    const uint32_t size = message.size() - sizeof(uint32_t);
+    memcpy(message.data(), &size, sizeof(size));
+}
+
+// Check if a path fits in a socket address
+inline bool fits(const std::string &path) {
+    return !path.empty() && (path.size() < sizeof(sockaddr_un::sun_path));
+}
+
+} // namespace
+
+/**
+ * @class Subagent::Session
+ * @brief Connection of a master agent, one request at a time.
+ */
+class Subagent::Session: public std::enable_shared_from_this<Session> {
+public:
+    Session(std::shared_ptr<Subagent> subagent, Socket socket) :
+            _subagent(std::move(subagent)), _socket(std::move(socket)) {
+    }
+
+    // Read the next request
+    void read() {
+        asio::async_read(_socket, asio::buffer(&_size, sizeof(_size)),
+                [self = shared_from_this()](const asio::error_code &error, size_t) {
+                    if (error || (self->_size > MAX_MESSAGE)) {
+                        self->close();
+                        return;
+                    }
+                    self->_request.resize(self->_size);
+                    asio::async_read(self->_socket, asio::buffer(self->_request),
+                            [self](const asio::error_code &error, size_t) {
+                                if (error || !self->_subagent->answer(self->_request, self->_response)) {
+                                    self->close();
+                                    return;
+                                }
+                                self->write();
+                            });
+                });
+    }
+
+    // Close the connection
+    void close() {
+        asio::error_code ignored;
+        _socket.close(ignored);
+    }
+
+private:
+    /** Subagent. */
+    std::shared_ptr<Subagent> _subagent;
+    /** Connection. */
+    Socket _socket;
+    /** Size of the request body. */
+    uint32_t _size = 0;
+    /** Request body. */
+    std::vector<uint8_t> _request;
+    /** Response message. */
+    std::vector<uint8_t> _response;
+
+    // Write the response, then read the next request
+    void write() {
+        asio::async_write(_socket, asio::buffer(_response),
+                [self = shared_from_this()](const asio::error_code &error, size_t) {
+                    if (error) {
+                        self->close();
+                        return;
+                    }
+                    self->read();
+                });
+    }
+};
+
+// Subagent constructor
+Subagent::Subagent(asio::io_context &io_context, MIB &mib) :
+        _mib(mib), _acceptor(io_context) {
+}
+
+// Create a subagent
+std::shared_ptr<Subagent> Subagent::create(asio::io_context &io_context, MIB &mib) {
+    return std::make_shared<Subagent>(io_context, mib);
+}
+
+// Listen for master agents
+bool Subagent::start(const char *path, const unsigned int mode) {
+    const std::string name(path);
+    if (!fits(name) || _acceptor.is_open()) {
+        return false;
+    }
+    // Replace a socket left by a previous run, never another file
+    struct stat status;
+    if ((stat(path, &status) == 0) && S_ISSOCK(status.st_mode)) {
+        unlink(path);
+    }
+    const asio::local::stream_protocol::endpoint endpoint(name);
+    asio::error_code error;
+    _acceptor.open(endpoint.protocol(), error);
+    if (!error) {
+        _acceptor.bind(endpoint, error);
+    }
+    // Restrict the socket before listening, no connection is possible before
+    const bool restricted = !error && (chmod(path, mode) == 0);
+    if (restricted) {
+        _acceptor.listen(asio::socket_base::max_listen_connections, error);
+    }
+    if (!restricted || error) {
+        asio::error_code ignored;
+        _acceptor.close(ignored);
+        return false;
+    }
+    accept();
+    return true;
+}
+
+// Stop listening and close connections
+bool Subagent::stop() {
+    if (!_acceptor.is_open()) {
+        return false;
+    }
+    asio::error_code ignored;
+    _acceptor.close(ignored);
+    for (std::weak_ptr<Session> &weak : _sessions) {
+        std::shared_ptr<Session> session = weak.lock();
+        if (session) {
+            session->close();
+        }
+    }
+    _sessions.clear();
+    return true;
+}
+
+// Accept the next connection
+void Subagent::accept() {
+    _acceptor.async_accept([self = shared_from_this()](const asio::error_code &error, Socket socket) {
+        if (error == asio::error::operation_aborted) {
+            return;
+        }
+        if (!error) {
+            // Forget closed connections
+            std::erase_if(self->_sessions, [](const std::weak_ptr<Session> &session) {
+                return session.expired();
+            });
+            auto session = std::make_shared<Session>(self, std::move(socket));
+            self->_sessions.push_back(session);
+            session->read();
+        }
+        if (self->_acceptor.is_open()) {
+            self->accept();
+        }
+    });
+}
+
+// Answer a request
+bool Subagent::answer(const std::vector<uint8_t> &request, std::vector<uint8_t> &response) {
+    size_t position = 0;
+    uint32_t id = 0;
+    uint32_t count = 0;
+    // A lookup takes at least 8 bytes, so a bogus count can't allocate much
+    if (!read32(request, position, id) || !read32(request, position, count)
+            || (count > (request.size() - position) / (2 * sizeof(uint32_t)))) {
+        return false;
+    }
+    std::vector<Lookup> lookups(count);
+    for (Lookup &lookup : lookups) {
+        uint32_t walk = 0;
+        if (!read32(request, position, walk) || !read(request, position, lookup._oid)) {
+            return false;
+        }
+        lookup._count = walk;
+    }
+    _mib.lookup(lookups);
+
+    response.clear();
+    append32(response, 0);
+    append32(response, id);
+    append32(response, count);
+    for (Lookup &lookup : lookups) {
+        append32(response, lookup._error);
+        append32(response, lookup._instances.size());
+        for (Instance &instance : lookup._instances) {
+            append(response, instance._oid);
+            const size_t size = instance._value->getSize(true);
+            append32(response, size);
+            const size_t offset = response.size();
+            response.resize(offset + size);
+            instance._value->encode(response.data() + offset);
+            delete instance._value;
+        }
+    }
+    seal(response);
+    return true;
+}
+
+// SubagentProvider constructor
+SubagentProvider::SubagentProvider(const char *path, const uint32_t timeout) :
+        _path(path), _timeout(timeout), _socket(_io_context) {
+}
+
+// Get the value of an instance
+BER* SubagentProvider::get(const ObjectIdentifier &oid) {
+    Lookup request {};
+    request._oid = oid;
+    std::vector<Lookup*> lookups { &request };
+    lookup(lookups);
+    return request._instances.empty() ? nullptr : request._instances[0]._value;
+}
+
+// Find the instance following an OID
+bool SubagentProvider::next(const ObjectIdentifier &oid, ObjectIdentifier &next) {
+    std::vector<Instance> instances;
+    if (!walk(oid, 1, instances)) {
+        return false;
+    }
+    next = instances[0]._oid;
+    delete instances[0]._value;
+    return true;
+}
+
+// Walk the instances following an OID
+size_t SubagentProvider::walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances) {
+    Lookup request {};
+    request._oid = oid;
+    request._count = count;
+    std::vector<Lookup*> lookups { &request };
+    lookup(lookups);
+    instances.insert(instances.end(), request._instances.begin(), request._instances.end());
+    return request._instances.size();
+}
+
+// Forward lookups to the subagent in one request
+void SubagentProvider::lookup(const std::vector<Lookup*> &lookups) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const uint32_t id = ++_id;
+    std::vector<uint8_t> request;
+    append32(request, 0);
+    append32(request, id);
+    append32(request, lookups.size());
+    for (const Lookup *lookup : lookups) {
+        append32(request, lookup->_count);
+        append(request, lookup->_oid);
+    }
+    seal(request);
+
+    // Values share the response buffer
+    auto response = std::make_shared<std::vector<uint8_t>>();
+    std::vector<size_t> sizes;
+    for (const Lookup *lookup : lookups) {
+        sizes.push_back(lookup->_instances.size());
+    }
+    bool success = exchange(request, *response);
+    size_t position = 0;
+    uint32_t value = 0;
+    if (success) {
+        success = read32(*response, position, value) && (value == id)
+                && read32(*response, position, value) && (value == lookups.size());
+    }
+    for (size_t index = 0; success && (index < lookups.size()); ++index) {
+        Lookup *lookup = lookups[index];
+        uint32_t count = 0;
+        success = read32(*response, position, value) && read32(*response, position, count);
+        lookup->_error = value;
+        for (uint32_t instance = 0; success && (instance < count); ++instance) {
+            ObjectIdentifier oid;
+            uint32_t size = 0;
+            success = read(*response, position, oid) && read32(*response, position, size)
+                    && (size >= 2) && (size <= response->size() - position);
+            if (success) {
+                lookup->_instances.push_back(Instance { oid, new EncodedBER(response->data() + position, size, response) });
+                position += size;
+            }
+        }
+    }
+    if (success) {
+        return;
+    }
+    // The connection can't be trusted anymore, drop what was read
+    asio::error_code ignored;
+    _socket.close(ignored);
+    for (size_t index = 0; index < lookups.size(); ++index) {
+        std::vector<Instance> &instances = lookups[index]->_instances;
+        for (size_t instance = sizes[index]; instance < instances.size(); ++instance) {
+            delete instances[instance]._value;
+        }
+        instances.resize(sizes[index]);
+        lookups[index]->_error = Error::GenErr;
+    }
+}
+
+// Send a request and wait for its response
+bool SubagentProvider::exchange(const std::vector<uint8_t> &request, std::vector<uint8_t> &response) {
+    if (!fits(_path)) {
+        return false;
+    }
+    bool done = false;
+    uint32_t size = 0;
+    auto send = [&]() {
+        asio::async_write(_socket, asio::buffer(request), [&](const asio::error_code &error, size_t) {
+            if (error) {
+                return;
+            }
+            asio::async_read(_socket, asio::buffer(&size, sizeof(size)), [&](const asio::error_code &error, size_t) {
+                if (error || (size > Subagent::MAX_MESSAGE)) {
+                    return;
+                }
+                response.resize(size);
+                asio::async_read(_socket, asio::buffer(response), [&](const asio::error_code &error, size_t) {
+                    done = !error;
+                });
+            });
+        });
+    };
+    _io_context.restart();
+    if (_socket.is_open()) {
+        send();
+    } else {
+        _socket.async_connect(asio::local::stream_protocol::endpoint(_path), [&](const asio::error_code &error) {
+            if (!error) {
+                send();
+            }
+        });
+    }
+    _io_context.run_for(std::chrono::milliseconds(_timeout));
+    if (!done) {
+        // Abort pending operations, their handlers refer to this frame
+        asio::error_code ignored;
+        _socket.close(ignored);
+        _io_context.restart();
+        _io_context.run();
+    }
+    return done;
+}
+
+} // namespace SNMP
+#endif
@@ -0,0 +1,393 @@
+#include "snmp_table.h"
+#include <algorithm>
+#include <mutex>
+
+namespace SNMP {
+
+namespace {
+
+// Storage classes of column types
+enum Storage : uint8_t {
+    Unsupported,
+    Values32,
+    Values64,
+    Strings
+};
+
+// Get the storage class of a column type
+Storage storage(const uint8_t type) {
+    switch (type) {
+    case Type::Integer:
+    case Type::Counter32:
+    case Type::Gauge32:
+    case Type::TimeTicks:
+    case Type::IPAddress:
+        return Values32;
+    case Type::Counter64:
+        return Values64;
+    case Type::OctetString:
+        return Strings;
+    default:
+        return Unsupported;
+    }
+}
+
+// Compare a row index with index arcs
+inline bool less(const ObjectIdentifier &index, const uint32_t *arcs, const size_t size) {
+    return std::lexicographical_compare(index.data(), index.data() + index.size(), arcs, arcs + size);
+}
+
+// Compare index arcs with a row index
+inline bool less(const uint32_t *arcs, const size_t size, const ObjectIdentifier &index) {
+    return std::lexicographical_compare(arcs, arcs + size, index.data(), index.data() + index.size());
+}
+
+// Write values of many rows into a column
+template<typename T, typename V>
+inline void scatter(std::vector<T> &column, const uint32_t *rows, const V *values, const size_t count) {
+    T *data = column.data();
+    for (size_t index = 0; index < count; ++index) {
+        data[rows[index]] = static_cast<T>(values[index]);
+    }
+}
+
+} // namespace
+
+// Table constructor
+Table::Table(const char *entry) :
+        _entry(entry) {
+}
+
+// Add a column
+uint32_t Table::addColumn(const uint32_t arc, const uint8_t type) {
+    Storage kind = storage(type);
+    if (kind == Unsupported) {
+        return NONE;
+    }
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    auto it = std::lower_bound(_sorted.begin(), _sorted.end(), arc, [this](const uint32_t handle, const uint32_t arc) {
+        return _columns[handle]._arc < arc;
+    });
+    if ((it != _sorted.end()) && (_columns[*it]._arc == arc)) {
+        return NONE;
+    }
+    Column column;
+    column._arc = arc;
+    column._type = type;
+    switch (kind) {
+    case Values32:
+        column._values32.resize(_indexes.size());
+        break;
+    case Values64:
+        column._values64.resize(_indexes.size());
+        break;
+    default:
+        column._strings.resize(_indexes.size());
+        break;
+    }
+    _columns.push_back(std::move(column));
+    _sorted.insert(it, _columns.size() - 1);
+    return _columns.size() - 1;
+}
+
+// Add a row
+uint32_t Table::addRow(const ObjectIdentifier &index) {
+    if (index.empty()) {
+        return NONE;
+    }
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    size_t at = position(index.data(), index.size(), true);
+    if ((at < _order.size()) && (_indexes[_order[at]] == index)) {
+        return _order[at];
+    }
+    uint32_t row;
+    if (_free.empty()) {
+        row = _indexes.size();
+        _indexes.emplace_back();
+        for (Column &column : _columns) {
+            switch (storage(column._type)) {
+            case Values32:
+                column._values32.push_back(0);
+                break;
+            case Values64:
+                column._values64.push_back(0);
+                break;
+            default:
+                column._strings.emplace_back();
+                break;
+            }
+        }
+    } else {
+        row = _free.back();
+        _free.pop_back();
+    }
+    _indexes[row] = index;
+    _order.insert(_order.begin() + at, row);
+    return row;
+}
+
+// Find a row
+uint32_t Table::findRow(const ObjectIdentifier &index) const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    size_t at = position(index.data(), index.size(), true);
+    if ((at < _order.size()) && (_indexes[_order[at]] == index)) {
+        return _order[at];
+    }
+    return NONE;
+}
+
+// Remove a row
+bool Table::removeRow(const uint32_t row) {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    if ((row >= _indexes.size()) || _indexes[row].empty()) {
+        return false;
+    }
+    const ObjectIdentifier &index = _indexes[row];
+    _order.erase(_order.begin() + position(index.data(), index.size(), true));
+    _indexes[row] = ObjectIdentifier();
+    for (Column &column : _columns) {
+        switch (storage(column._type)) {
+        case Values32:
+            column._values32[row] = 0;
+            break;
+        case Values64:
+            column._values64[row] = 0;
+            break;
+        default:
+            column._strings[row].clear();
+            break;
+        }
+    }
+    _free.push_back(row);
+    return true;
+}
+
+// Get the count of rows
+size_t Table::getRowCount() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _order.size();
+}
+
+// Set an Integer value
+bool Table::setInteger(const uint32_t row, const uint32_t column, const int32_t value) {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    if (!valid(row, column) || (_columns[column]._type != Type::Integer)) {
+        return false;
+    }
+    _columns[column]._values32[row] = value;
+    return true;
+}
+
+// Set an unsigned value
+bool Table::setUnsigned(const uint32_t row, const uint32_t column, const uint64_t value) {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    if (!valid(row, column) || (_columns[column]._type == Type::Integer)) {
+        return false;
+    }
+    switch (storage(_columns[column]._type)) {
+    case Values32:
+        _columns[column]._values32[row] = value;
+        return true;
+    case Values64:
+        _columns[column]._values64[row] = value;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Set an OctetString value
+bool Table::setString(const uint32_t row, const uint32_t column, const char *value, const size_t length) {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    if (!valid(row, column) || (storage(_columns[column]._type) != Strings)) {
+        return false;
+    }
+    _columns[column]._strings[row].assign(value, length);
+    return true;
+}
+
+// Set Integer values of many rows
+bool Table::setInteger(const uint32_t column, const uint32_t *rows, const int32_t *values, const size_t count) {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    if ((column >= _columns.size()) || (_columns[column]._type != Type::Integer) || !valid(rows, count)) {
+        return false;
+    }
+    scatter(_columns[column]._values32, rows, values, count);
+    return true;
+}
+
+// Set 32-bit unsigned values of many rows
+bool Table::setUnsigned(const uint32_t column, const uint32_t *rows, const uint32_t *values, const size_t count) {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    if ((column >= _columns.size()) || (_columns[column]._type == Type::Integer) || !valid(rows, count)) {
+        return false;
+    }
+    switch (storage(_columns[column]._type)) {
+    case Values32:
+        scatter(_columns[column]._values32, rows, values, count);
+        return true;
+    case Values64:
+        scatter(_columns[column]._values64, rows, values, count);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Set 64-bit unsigned values of many rows
+bool Table::setUnsigned(const uint32_t column, const uint32_t *rows, const uint64_t *values, const size_t count) {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    if ((column >= _columns.size()) || (_columns[column]._type == Type::Integer) || !valid(rows, count)) {
+        return false;
+    }
+    switch (storage(_columns[column]._type)) {
+    case Values32:
+        scatter(_columns[column]._values32, rows, values, count);
+        return true;
+    case Values64:
+        scatter(_columns[column]._values64, rows, values, count);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Get the value of an instance
+BER* Table::get(const ObjectIdentifier &oid) {
+    const size_t base = _entry.size();
+    if ((oid.size() < base + 2) || !oid.startsWith(_entry)) {
+        return nullptr;
+    }
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    auto it = std::lower_bound(_sorted.begin(), _sorted.end(), oid[base], [this](const uint32_t handle, const uint32_t arc) {
+        return _columns[handle]._arc < arc;
+    });
+    if ((it == _sorted.end()) || (_columns[*it]._arc != oid[base])) {
+        return nullptr;
+    }
+    const uint32_t *index = oid.data() + base + 1;
+    const size_t size = oid.size() - base - 1;
+    size_t at = position(index, size, true);
+    if ((at == _order.size()) || less(index, size, _indexes[_order[at]])) {
+        return nullptr;
+    }
+    return value(_columns[*it], _order[at]);
+}
+
+// Find the instance following an OID
+bool Table::next(const ObjectIdentifier &oid, ObjectIdentifier &next) {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    size_t column;
+    size_t row;
+    if (!locate(oid, column, row) || _order.empty()) {
+        return false;
+    }
+    if (row == _order.size()) {
+        column++;
+        row = 0;
+    }
+    if (column == _sorted.size()) {
+        return false;
+    }
+    const uint32_t slot = _order[row];
+    next = _entry;
+    next.append(_columns[_sorted[column]]._arc);
+    next.append(_indexes[slot].data(), _indexes[slot].size());
+    return true;
+}
+
+// Walk the instances following an OID
+size_t Table::walk(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances) {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return scan(oid, count, instances);
+}
+
+// Create the value of a cell
+BER* Table::value(const Column &column, const uint32_t row) {
+    switch (column._type) {
+    case Type::Integer:
+        return new IntegerBER(static_cast<int32_t>(column._values32[row]));
+    case Type::Counter32:
+        return new Counter32BER(column._values32[row]);
+    case Type::Gauge32:
+        return new Gauge32BER(column._values32[row]);
+    case Type::TimeTicks:
+        return new TimeTicksBER(column._values32[row]);
+    case Type::IPAddress:
+        return new IPAddressBER(IPAddress(column._values32[row]));
+    case Type::Counter64:
+        return new Counter64BER(column._values64[row]);
+    default:
+        return new OctetStringBER(column._strings[row].data(), column._strings[row].size());
+    }
+}
+
+// Check row handles
+bool Table::valid(const uint32_t *rows, const size_t count) const {
+    for (size_t index = 0; index < count; ++index) {
+        if ((rows[index] >= _indexes.size()) || _indexes[rows[index]].empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Find the position of the first row after an index
+size_t Table::position(const uint32_t *index, const size_t size, const bool inclusive) const {
+    if (inclusive) {
+        return std::lower_bound(_order.begin(), _order.end(), 0, [&](const uint32_t row, int) {
+            return less(_indexes[row], index, size);
+        }) - _order.begin();
+    }
+    return std::upper_bound(_order.begin(), _order.end(), 0, [&](int, const uint32_t row) {
+        return less(index, size, _indexes[row]);
+    }) - _order.begin();
+}
+
+// Find the column and row of the first instance after an OID
+bool Table::locate(const ObjectIdentifier &oid, size_t &column, size_t &row) const {
+    const size_t base = _entry.size();
+    column = 0;
+    row = 0;
+    if (oid.startsWith(_entry)) {
+        if (oid.size() > base) {
+            // Start after the instance in its column, or at the first row of the next column
+            column = std::lower_bound(_sorted.begin(), _sorted.end(), oid[base], [this](const uint32_t handle, const uint32_t arc) {
+                return _columns[handle]._arc < arc;
+            }) - _sorted.begin();
+            if ((column < _sorted.size()) && (_columns[_sorted[column]]._arc == oid[base])) {
+                row = position(oid.data() + base + 1, oid.size() - base - 1, false);
+            }
+        }
+        return true;
+    }
+    return oid < _entry;
+}
+
+// Walk without locking, column by column then row by row
+size_t Table::scan(const ObjectIdentifier &oid, const size_t count, std::vector<Instance> &instances) const {
+    size_t column;
+    size_t row;
+    if (!locate(oid, column, row)) {
+        return 0;
+    }
+
+    size_t appended = 0;
+    while ((appended < count) && (column < _sorted.size())) {
+        const Column &current = _columns[_sorted[column]];
+        for (; (row < _order.size()) && (appended < count); ++row, ++appended) {
+            const uint32_t slot = _order[row];
+            ObjectIdentifier instance = _entry;
+            instance.append(current._arc);
+            instance.append(_indexes[slot].data(), _indexes[slot].size());
+            instances.push_back(Instance { std::move(instance), value(current, slot) });
+        }
+        if (row == _order.size()) {
+            column++;
+            row = 0;
+        }
+    }
+    return appended;
+}
+
+} // namespace SNMP
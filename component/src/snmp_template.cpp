@@ -0,0 +1,245 @@
+#include "snmp_template.h"
+#include <cstring>
+
+#if !SNMP_STREAM
+
+namespace SNMP {
+
+namespace {
+
+// Gets the size of an encoded length
+inline uint32_t lengthSize(const uint32_t length) {
+    uint32_t size = 1;
+    if (length > 0x7F) {
+        for (uint32_t value = length; value; value >>= 8) {
+            size++;
+        }
+    }
+    return size;
+}
+
+// Encodes a length, short or long form
+uint8_t* encodeLength(uint8_t *pointer, const uint32_t length) {
+    uint32_t size = lengthSize(length);
+    if (size == 1) {
+        *pointer++ = length;
+        return pointer;
+    }
+    *pointer++ = 0x80 | (size - 1);
+    for (uint32_t index = size - 1; index > 0; --index) {
+        *pointer++ = length >> ((index - 1) << 3);
+    }
+    return pointer;
+}
+
+// Gets the count of bytes of a two's complement integer
+inline uint8_t signedWidth(const int64_t value) {
+    uint8_t width = 1;
+    while ((width < 8) && ((value >> ((width << 3) - 1)) != 0) && ((value >> ((width << 3) - 1)) != -1)) {
+        width++;
+    }
+    return width;
+}
+
+// Gets the count of bytes of an unsigned integer, with a leading 0 if the most significant bit is set
+inline uint8_t unsignedWidth(const uint64_t value) {
+    uint8_t width = 1;
+    while ((width < 9) && (value >> ((width << 3) - 1))) {
+        width++;
+    }
+    return width;
+}
+
+// Encodes the content of an integer, most significant byte first
+inline void encodeContent(uint8_t *pointer, const uint64_t value, const uint8_t width) {
+    for (uint8_t index = width; index > 0; --index) {
+        *pointer++ = (index > 8) ? 0 : value >> ((index - 1) << 3);
+    }
+}
+
+// Encodes a BER object into a vector
+std::vector<uint8_t> encodeBER(BER *ber) {
+    std::vector<uint8_t> encoded(ber->getSize(true));
+    ber->encode(encoded.data());
+    return encoded;
+}
+
+} // namespace
+
+// Response template constructor
+ResponseTemplate::ResponseTemplate(const uint8_t version, const char *community, const uint8_t type) :
+        _type(type), _header(), _requestID(), _status(), _index() {
+    size_t length = community ? strlen(community) : 0;
+    uint8_t *pointer = prepare(_header, 4 + lengthSize(length) + length);
+    *pointer++ = Type::Integer;
+    *pointer++ = 1;
+    *pointer++ = version;
+    *pointer++ = Type::OctetString;
+    pointer = encodeLength(pointer, length);
+    if (length) {
+        memcpy(pointer, community, length);
+    }
+    setRequestID(0);
+    setError(Error::NoError, 0);
+}
+
+// Add a variable binding
+uint32_t ResponseTemplate::add(const char *oid, BER *value) {
+    ObjectIdentifierBER name(oid);
+    if (!value) {
+        value = new NullBER();
+    }
+    std::vector<uint8_t> encodedName = encodeBER(&name);
+    std::vector<uint8_t> encodedValue = encodeBER(value);
+    delete value;
+    _bindings.push_back(Binding());
+    Binding &binding = _bindings.back();
+    memcpy(prepare(binding._name, encodedName.size()), encodedName.data(), encodedName.size());
+    memcpy(prepare(binding._value, encodedValue.size()), encodedValue.data(), encodedValue.size());
+    commit();
+    return _bindings.size() - 1;
+}
+
+// Set the request identifier
+void ResponseTemplate::setRequestID(const int32_t requestID) {
+    uint8_t width = signedWidth(requestID);
+    uint8_t *pointer = prepare(_requestID, 2 + width);
+    *pointer++ = Type::Integer;
+    *pointer++ = width;
+    encodeContent(pointer, requestID, width);
+    commit();
+}
+
+// Set error status and error index
+void ResponseTemplate::setError(const uint8_t status, const uint32_t index) {
+    uint8_t width = unsignedWidth(status);
+    uint8_t *pointer = prepare(_status, 2 + width);
+    *pointer++ = Type::Integer;
+    *pointer++ = width;
+    encodeContent(pointer, status, width);
+    width = unsignedWidth(index);
+    pointer = prepare(_index, 2 + width);
+    *pointer++ = Type::Integer;
+    *pointer++ = width;
+    encodeContent(pointer, index, width);
+    commit();
+}
+
+// Set a value from a BER object
+bool ResponseTemplate::setValue(const uint32_t index, BER *value) {
+    if (index >= _bindings.size()) {
+        delete value;
+        return false;
+    }
+    std::vector<uint8_t> encoded = encodeBER(value);
+    delete value;
+    memcpy(prepare(_bindings[index]._value, encoded.size()), encoded.data(), encoded.size());
+    commit();
+    return true;
+}
+
+// Set an INTEGER value
+bool ResponseTemplate::setInteger(const uint32_t index, const int32_t value) {
+    if (index >= _bindings.size()) {
+        return false;
+    }
+    uint8_t width = signedWidth(value);
+    uint8_t *pointer = prepare(_bindings[index]._value, 2 + width);
+    *pointer++ = Type::Integer;
+    *pointer++ = width;
+    encodeContent(pointer, value, width);
+    commit();
+    return true;
+}
+
+// Set an unsigned value
+bool ResponseTemplate::setUnsigned(const uint32_t index, const uint8_t type, const uint64_t value) {
+    if (index >= _bindings.size()) {
+        return false;
+    }
+    uint8_t width = unsignedWidth(value);
+    uint8_t *pointer = prepare(_bindings[index]._value, 2 + width);
+    *pointer++ = type;
+    *pointer++ = width;
+    encodeContent(pointer, value, width);
+    commit();
+    return true;
+}
+
+// Set an OCTET STRING value
+bool ResponseTemplate::setOctetString(const uint32_t index, const char *value, const size_t length) {
+    if (index >= _bindings.size()) {
+        return false;
+    }
+    uint8_t *pointer = prepare(_bindings[index]._value, 1 + lengthSize(length) + length);
+    *pointer++ = Type::OctetString;
+    pointer = encodeLength(pointer, length);
+    if (length) {
+        memcpy(pointer, value, length);
+    }
+    commit();
+    return true;
+}
+
+// Get room to encode a field, in place or staged
+uint8_t* ResponseTemplate::prepare(Field &field, const uint32_t size) {
+    if (size != field._size) {
+        field._offset = _buffer.size();
+        field._size = size;
+        _buffer.resize(_buffer.size() + size);
+        _staged = true;
+    }
+    return _buffer.data() + field._offset;
+}
+
+// Lay the message out if needed
+void ResponseTemplate::commit() {
+    if (_staged) {
+        layout();
+        _staged = false;
+    }
+}
+
+// Lay the message out, moving all fields to their final place
+void ResponseTemplate::layout() {
+    // Compute lengths from the inside out
+    uint32_t list = 0;
+    for (const Binding &binding : _bindings) {
+        uint32_t length = binding._name._size + binding._value._size;
+        list += 1 + lengthSize(length) + length;
+    }
+    uint32_t pdu = _requestID._size + _status._size + _index._size + 1 + lengthSize(list) + list;
+    uint32_t message = _header._size + 1 + lengthSize(pdu) + pdu;
+    _size = 1 + lengthSize(message) + message;
+
+    // Copy fields and write lengths
+    _layout.resize(_size);
+    uint8_t *start = _layout.data();
+    uint8_t *pointer = start;
+    auto move = [&](Field &field) {
+        memcpy(pointer, _buffer.data() + field._offset, field._size);
+        field._offset = pointer - start;
+        pointer += field._size;
+    };
+    *pointer++ = Type::Sequence;
+    pointer = encodeLength(pointer, message);
+    move(_header);
+    *pointer++ = _type;
+    pointer = encodeLength(pointer, pdu);
+    move(_requestID);
+    move(_status);
+    move(_index);
+    *pointer++ = Type::Sequence;
+    pointer = encodeLength(pointer, list);
+    for (Binding &binding : _bindings) {
+        *pointer++ = Type::Sequence;
+        pointer = encodeLength(pointer, binding._name._size + binding._value._size);
+        move(binding._name);
+        move(binding._value);
+    }
+    _buffer.swap(_layout);
+}
+
+} // namespace SNMP
+
+#endif
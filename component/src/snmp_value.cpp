@@ -0,0 +1,355 @@
+#include "snmp_value.h"
+#include <cstring>
+
+#if !SNMP_STREAM
+
+namespace SNMP {
+
+namespace {
+
+/** Encoded type and length of the float embedded in an Opaque. */
+constexpr uint8_t FLOAT_HEADER[] = { 0x9F, 0x78, 0x04 };
+
+// Gets the size of an encoded length
+inline uint32_t lengthSize(const uint32_t length) {
+    uint32_t size = 1;
+    if (length > 0x7F) {
+        for (uint32_t value = length; value; value >>= 8) {
+            size++;
+        }
+    }
+    return size;
+}
+
+// Encodes a length, short or long form
+inline uint8_t* encodeLength(uint8_t *pointer, const uint32_t length) {
+    if (length <= 0x7F) {
+        *pointer++ = length;
+        return pointer;
+    }
+    const uint32_t size = lengthSize(length) - 1;
+    *pointer++ = 0x80 | size;
+    for (uint32_t index = size; index > 0; --index) {
+        *pointer++ = length >> ((index - 1) << 3);
+    }
+    return pointer;
+}
+
+// Reads a length, checking it fits in the remaining bytes
+inline bool readLength(const uint8_t *&pointer, const uint8_t *end, size_t &length) {
+    if (pointer >= end) {
+        return false;
+    }
+    length = *pointer++;
+    if (length & 0x80) {
+        uint8_t size = length & 0x7F;
+        if ((size == 0) || (size > 4) || (end - pointer < size)) {
+            return false;
+        }
+        length = 0;
+        while (size--) {
+            length = (length << 8) | *pointer++;
+        }
+    }
+    return length <= static_cast<size_t>(end - pointer);
+}
+
+// Gets the count of bytes of a two's complement integer
+inline uint8_t signedWidth(const int64_t value) {
+    uint8_t width = 1;
+    while ((width < 8) && ((value >> ((width << 3) - 1)) != 0) && ((value >> ((width << 3) - 1)) != -1)) {
+        width++;
+    }
+    return width;
+}
+
+// Gets the count of bytes of an unsigned integer, with a leading 0 if the most significant bit is set
+inline uint8_t unsignedWidth(const uint64_t value) {
+    uint8_t width = 1;
+    while ((width < 9) && (value >> ((width << 3) - 1))) {
+        width++;
+    }
+    return width;
+}
+
+// Encodes the content of an integer, most significant byte first
+inline uint8_t* encodeInteger(uint8_t *pointer, const uint64_t value, const uint8_t width) {
+    for (uint8_t index = width; index > 0; --index) {
+        *pointer++ = (index > 8) ? 0 : value >> ((index - 1) << 3);
+    }
+    return pointer;
+}
+
+// Encodes an OID, type, length and content
+inline uint8_t* encodeOID(uint8_t *pointer, const ObjectIdentifier &oid, const uint32_t length) {
+    *pointer++ = Type::ObjectIdentifier;
+    pointer = encodeLength(pointer, length);
+    return oid.encode(pointer);
+}
+
+// Gets the size of the content of a value
+uint32_t contentLength(const uint16_t type, const std::variant<int64_t, float, std::string, ObjectIdentifier> &data) {
+    switch (type) {
+    case Type::Boolean:
+        return 1;
+    case Type::Integer:
+        return signedWidth(*std::get_if<int64_t>(&data));
+    case Type::Counter32:
+    case Type::Gauge32:
+    case Type::TimeTicks:
+    case Type::Counter64:
+        return unsignedWidth(*std::get_if<int64_t>(&data));
+    case Type::OctetString:
+    case Type::IPAddress:
+    case Type::Opaque:
+        return std::get_if<std::string>(&data)->size();
+    case Type::ObjectIdentifier:
+        return std::get_if<ObjectIdentifier>(&data)->getLength();
+    case Type::OpaqueFloat:
+        return sizeof(FLOAT_HEADER) + sizeof(float);
+    default:
+        return 0;
+    }
+}
+
+// Gets the size of the content of a variable binding
+inline uint32_t bindingLength(const Value::Binding &binding) {
+    const uint32_t name = binding._oid.getLength();
+    return 1 + lengthSize(name) + name + binding._value.getSize();
+}
+
+// Gets the size of the content of a variable bindings list
+uint32_t listLength(const std::vector<Value::Binding> &bindings) {
+    uint32_t length = 0;
+    for (const Value::Binding &binding : bindings) {
+        const uint32_t content = bindingLength(binding);
+        length += 1 + lengthSize(content) + content;
+    }
+    return length;
+}
+
+} // namespace
+
+// Value constructor from an IP address
+Value::Value(const IPAddress &value) :
+        _type(Type::IPAddress), _data(std::string(4, '\0')) {
+    std::string &bytes = *std::get_if<std::string>(&_data);
+    for (uint8_t index = 0; index < 4; ++index) {
+        bytes[index] = value[index];
+    }
+}
+
+// Create a value from a BER object
+Value Value::from(BER *ber) {
+    Value value;
+    if (!ber) {
+        return value;
+    }
+    std::vector<uint8_t> encoded(ber->getSize(true));
+    ber->encode(encoded.data());
+    const uint8_t *pointer = encoded.data();
+    if (!value.decode(pointer, pointer + encoded.size())) {
+        return Value();
+    }
+    return value;
+}
+
+// Get the bytes of an OctetString, IPAddress or Opaque
+const std::string& Value::getBytes() const {
+    static const std::string empty;
+    const std::string *bytes = std::get_if<std::string>(&_data);
+    return bytes ? *bytes : empty;
+}
+
+// Get an OID
+const ObjectIdentifier& Value::getOID() const {
+    static const ObjectIdentifier empty;
+    const ObjectIdentifier *oid = std::get_if<ObjectIdentifier>(&_data);
+    return oid ? *oid : empty;
+}
+
+// Get the size of the encoded value
+unsigned int Value::getSize() const {
+    const uint32_t length = contentLength(_type, _data);
+    return 1 + lengthSize(length) + length;
+}
+
+// Encode the value
+uint8_t* Value::encode(uint8_t *buffer) const {
+    const uint32_t length = contentLength(_type, _data);
+    uint8_t *pointer = buffer;
+    switch (_type) {
+    case Type::Boolean:
+        *pointer++ = Type::Boolean;
+        *pointer++ = 1;
+        *pointer++ = *std::get_if<int64_t>(&_data) ? 0xFF : 0x00;
+        return pointer;
+    case Type::Integer:
+    case Type::Counter32:
+    case Type::Gauge32:
+    case Type::TimeTicks:
+    case Type::Counter64:
+        *pointer++ = _type;
+        *pointer++ = length;
+        return encodeInteger(pointer, *std::get_if<int64_t>(&_data), length);
+    case Type::OctetString:
+    case Type::IPAddress:
+    case Type::Opaque: {
+        const std::string &bytes = *std::get_if<std::string>(&_data);
+        *pointer++ = _type;
+        pointer = encodeLength(pointer, length);
+        memcpy(pointer, bytes.data(), length);
+        return pointer + length;
+    }
+    case Type::ObjectIdentifier:
+        return encodeOID(pointer, *std::get_if<ObjectIdentifier>(&_data), length);
+    case Type::OpaqueFloat: {
+        uint32_t bits;
+        memcpy(&bits, std::get_if<float>(&_data), sizeof(bits));
+        *pointer++ = Type::Opaque;
+        *pointer++ = length;
+        memcpy(pointer, FLOAT_HEADER, sizeof(FLOAT_HEADER));
+        return encodeInteger(pointer + sizeof(FLOAT_HEADER), bits, sizeof(bits));
+    }
+    default:
+        *pointer++ = _type;
+        *pointer++ = 0;
+        return pointer;
+    }
+}
+
+// Decode a value
+bool Value::decode(const uint8_t *&pointer, const uint8_t *end) {
+    size_t length = 0;
+    if (pointer >= end) {
+        return false;
+    }
+    const uint8_t type = *pointer++;
+    if (!readLength(pointer, end, length)) {
+        return false;
+    }
+    const uint8_t *content = pointer;
+    pointer += length;
+    switch (type) {
+    case Type::Boolean:
+        if (length != 1) {
+            return false;
+        }
+        *this = boolean(*content);
+        return true;
+    case Type::Integer: {
+        if ((length == 0) || (length > 8)) {
+            return false;
+        }
+        int64_t value = static_cast<int8_t>(*content++);
+        while (--length) {
+            value = (value << 8) | *content++;
+        }
+        *this = Value(Type::Integer, value);
+        return true;
+    }
+    case Type::Counter32:
+    case Type::Gauge32:
+    case Type::TimeTicks:
+    case Type::Counter64: {
+        // A leading 0 keeps the most significant bit clear
+        const size_t maximum = (type == Type::Counter64) ? 9 : 5;
+        if ((length == 0) || (length > maximum) || ((length == maximum) && *content)) {
+            return false;
+        }
+        uint64_t value = 0;
+        while (length--) {
+            value = (value << 8) | *content++;
+        }
+        if ((type != Type::Counter64) && (value > UINT32_MAX)) {
+            return false;
+        }
+        *this = Value(type, int64_t(value));
+        return true;
+    }
+    case Type::OctetString:
+    case Type::IPAddress:
+        *this = Value(type, std::string(reinterpret_cast<const char*>(content), length));
+        return (type != Type::IPAddress) || (length == 4);
+    case Type::Opaque:
+        if ((length == sizeof(FLOAT_HEADER) + sizeof(float))
+                && !memcmp(content, FLOAT_HEADER, sizeof(FLOAT_HEADER))) {
+            content += sizeof(FLOAT_HEADER);
+            const uint32_t bits = (uint32_t(content[0]) << 24) | (content[1] << 16) | (content[2] << 8) | content[3];
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            *this = Value(value);
+        } else {
+            *this = opaque(content, length);
+        }
+        return true;
+    case Type::ObjectIdentifier: {
+        ObjectIdentifier oid;
+        if (!oid.decode(content, length)) {
+            return false;
+        }
+        *this = Value(std::move(oid));
+        return true;
+    }
+    case Type::Null:
+    case Type::NoSuchObject:
+    case Type::NoSuchInstance:
+    case Type::EndOfMIBView:
+        *this = null(type);
+        return length == 0;
+    default:
+        return false;
+    }
+}
+
+// Get the size of an encoded variable bindings list
+unsigned int Value::getSize(const std::vector<Binding> &bindings) {
+    const uint32_t length = listLength(bindings);
+    return 1 + lengthSize(length) + length;
+}
+
+// Encode a variable bindings list
+uint8_t* Value::encode(const std::vector<Binding> &bindings, uint8_t *buffer) {
+    uint8_t *pointer = buffer;
+    *pointer++ = Type::Sequence;
+    pointer = encodeLength(pointer, listLength(bindings));
+    for (const Binding &binding : bindings) {
+        *pointer++ = Type::Sequence;
+        pointer = encodeLength(pointer, bindingLength(binding));
+        pointer = encodeOID(pointer, binding._oid, binding._oid.getLength());
+        pointer = binding._value.encode(pointer);
+    }
+    return pointer;
+}
+
+// Decode a variable bindings list
+bool Value::decode(const uint8_t *data, const size_t size, std::vector<Binding> &bindings) {
+    const uint8_t *pointer = data;
+    const uint8_t *end = data + size;
+    size_t length = 0;
+    if ((pointer >= end) || (*pointer++ != Type::Sequence) || !readLength(pointer, end, length)) {
+        return false;
+    }
+    end = pointer + length;
+    while (pointer < end) {
+        if ((*pointer++ != Type::Sequence) || !readLength(pointer, end, length)) {
+            return false;
+        }
+        const uint8_t *next = pointer + length;
+        Binding &binding = bindings.emplace_back();
+        bool valid = (pointer < next) && (*pointer++ == Type::ObjectIdentifier) && readLength(pointer, next, length)
+                && binding._oid.decode(pointer, length);
+        if (valid) {
+            pointer += length;
+            valid = binding._value.decode(pointer, next) && (pointer == next);
+        }
+        if (!valid) {
+            bindings.pop_back();
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace SNMP
+#endif
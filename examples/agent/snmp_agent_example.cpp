@@ -3,7 +3,11 @@
  * 
  * This example demonstrates how to create a simple SNMP Agent using the SNMP-ASIO library.
  * The agent implements a minimal MIB with system information and responds to SNMP GET, 
- * GETNEXT, and SET requests.
+ * GETNEXT, GETBULK and SET requests.
+ *
+ * Requests are served by an SNMP::MIB, with the system group provided by SimpleMIB and
+ * an expensive object cached by the library. SET requests are applied by the MIB as a
+ * whole or not at all, through the test/commit/undo phases of SimpleMIB.
  */
 
 #include <snmp.h>
@@ -14,6 +18,7 @@
 #include <csignal>
 #include <map>
 #include <chrono>
+#include <filesystem>
 
 // Global variables for signal handling
 asio::io_context* g_io_context = nullptr;
@@ -34,59 +39,88 @@ const char* SYSDESCR_OID = "1.3.6.1.2.1.1.1.0";    // SNMPv2-MIB::sysDescr.0
 const char* SYSUPTIME_OID = "1.3.6.1.2.1.1.3.0";   // SNMPv2-MIB::sysUpTime.0
 const char* SYSCONTACT_OID = "1.3.6.1.2.1.1.4.0";  // SNMPv2-MIB::sysContact.0
 const char* SYSLOCATION_OID = "1.3.6.1.2.1.1.6.0"; // SNMPv2-MIB::sysLocation.0
+const char* SYSTEM_OID = "1.3.6.1.2.1.1";          // SNMPv2-MIB::system
+const char* HRSYSTEMPROCESSES_OID = "1.3.6.1.2.1.25.1.6.0"; // HOST-RESOURCES-MIB::hrSystemProcesses.0
 
 /**
  * Simple MIB implementation that stores values in memory
  */
-class SimpleMIB {
+class SimpleMIB : public SNMP::Provider {
 public:
     SimpleMIB() {
         // Initialize with default values
-        mib_values[SYSNAME_OID] = "SNMP-Asio Example Device";
-        mib_values[SYSDESCR_OID] = "Example SNMP Agent using SNMP-ASIO library";
-        mib_values[SYSCONTACT_OID] = "admin@example.com";
-        mib_values[SYSLOCATION_OID] = "Server Room";
+        mib_values[SNMP::ObjectIdentifier(SYSNAME_OID)] = "SNMP-Asio Example Device";
+        mib_values[SNMP::ObjectIdentifier(SYSDESCR_OID)] = "Example SNMP Agent using SNMP-ASIO library";
+        mib_values[SNMP::ObjectIdentifier(SYSCONTACT_OID)] = "admin@example.com";
+        mib_values[SNMP::ObjectIdentifier(SYSLOCATION_OID)] = "Server Room";
     }
 
     // Get a value for an OID
-    std::unique_ptr<SNMP::BER> getValue(const std::string& oid) {
+    SNMP::BER* get(const SNMP::ObjectIdentifier& oid) override {
         auto it = mib_values.find(oid);
         if (it != mib_values.end()) {
-            return std::make_unique<SNMP::OctetStringBER>(it->second.c_str());
-        } else if (oid == SYSUPTIME_OID) {
+            return new SNMP::OctetStringBER(it->second.c_str());
+        } else if (oid == uptime_oid) {
             // Special case for sysUpTime which is dynamic
-            return std::make_unique<SNMP::TimeTicksBER>(getUptime());
+            return new SNMP::TimeTicksBER(getUptime());
         }
         return nullptr;
     }
 
-    // Set a value for an OID
-    bool setValue(const std::string& oid, const std::string& value) {
+    // Check a SET before anything is applied
+    uint8_t test(SNMP::Change& change) override {
         // Only allow setting certain OIDs
-        if (oid == SYSNAME_OID || oid == SYSCONTACT_OID || oid == SYSLOCATION_OID) {
-            mib_values[oid] = value;
-            std::cout << "Set " << oid << " to '" << value << "'" << std::endl;
-            return true;
+        if (!(change._oid == sysname_oid || change._oid == syscontact_oid || change._oid == syslocation_oid)) {
+            return SNMP::Error::NotWritable;
+        }
+        if (change._value->getType() != SNMP::Type::OctetString) {
+            return SNMP::Error::WrongType;
         }
-        return false;
+        // DisplayString is limited to 255 characters
+        if (change._value->getLength() > 255) {
+            return SNMP::Error::WrongLength;
+        }
+        return SNMP::Error::NoError;
     }
 
-    // Get the next OID in lexicographical order
-    std::string getNextOID(const std::string& oid) {
-        // Find the next OID in lexicographical order
-        for (const auto& entry : mib_values) {
-            if (entry.first > oid) {
-                return entry.first;
-            }
+    // Apply a tested SET, keeping the previous value for undo
+    uint8_t commit(SNMP::Change& change) override {
+        std::string& value = mib_values[change._oid];
+        change._undo = std::make_unique<SNMP::OctetStringBER>(value.data(), value.size());
+        auto string_value = static_cast<SNMP::OctetStringBER*>(change._value);
+        value.assign(string_value->getValue(), string_value->getLength());
+        std::cout << "Set " << change._oid.toString() << " to '" << value << "'" << std::endl;
+        return SNMP::Error::NoError;
+    }
+
+    // Revert a committed SET when a later one failed
+    bool undo(SNMP::Change& change) override {
+        auto previous = static_cast<SNMP::OctetStringBER*>(change._undo.get());
+        mib_values[change._oid].assign(previous->getValue(), previous->getLength());
+        return true;
+    }
+
+    // Get the next OID in MIB order
+    bool next(const SNMP::ObjectIdentifier& oid, SNMP::ObjectIdentifier& next) override {
+        auto it = mib_values.upper_bound(oid);
+        bool found = it != mib_values.end();
+        if (found) {
+            next = it->first;
         }
-        if (oid < SYSUPTIME_OID && SYSUPTIME_OID > oid) {
-            return SYSUPTIME_OID;
+        // sysUpTime is not stored
+        if (oid < uptime_oid && (!found || uptime_oid < next)) {
+            next = uptime_oid;
+            found = true;
         }
-        return ""; // No more OIDs
+        return found;
     }
 
 private:
-    std::map<std::string, std::string> mib_values;
+    std::map<SNMP::ObjectIdentifier, std::string> mib_values;
+    const SNMP::ObjectIdentifier uptime_oid{SYSUPTIME_OID};
+    const SNMP::ObjectIdentifier sysname_oid{SYSNAME_OID};
+    const SNMP::ObjectIdentifier syscontact_oid{SYSCONTACT_OID};
+    const SNMP::ObjectIdentifier syslocation_oid{SYSLOCATION_OID};
     
     // Get current uptime in hundredths of a second
     uint32_t getUptime() const {
@@ -97,14 +131,34 @@ private:
     }
 };
 
+// Count running processes, expensive enough to be cached
+uint32_t countProcesses() {
+    uint32_t count = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/proc", ec)) {
+        const std::string name = entry.path().filename().string();
+        if (!name.empty() && name.find_first_not_of("0123456789") == std::string::npos) {
+            count++;
+        }
+    }
+    return count;
+}
+
 /**
  * Main SNMP Agent application class
  */
 class SNMPAgentApp {
 public:
-    SNMPAgentApp() : io_context_() {
+    SNMPAgentApp() : io_context_(), system_(std::make_shared<SimpleMIB>()) {
         // Store global reference for signal handler
         g_io_context = &io_context_;
+        
+        // Register providers
+        mib_.add(SYSTEM_OID, system_);
+        // Cached 5 seconds, refreshed in the background 1 second before expiry
+        mib_.add(HRSYSTEMPROCESSES_OID, []() {
+            return new SNMP::Gauge32BER(countProcesses());
+        }, {5000, 5000, 1000});
     }
 
     ~SNMPAgentApp() {
@@ -206,11 +260,8 @@ private:
             return;
         }
         
-        // Get the variable binding list from the message
-        auto varbindlist = message->getVarBindList();
-        
         // Create an appropriate response based on the request type
-        auto response = createResponse(message, type, version, community, varbindlist);
+        auto response = createResponse(message, type);
         
         // Send the response
         if (response) {
@@ -219,135 +270,25 @@ private:
     }
     
     // Create appropriate SNMP response based on the request type
-    std::unique_ptr<SNMP::Message> createResponse(
-        const SNMP::Message* request,
-        uint8_t type,
-        uint8_t version,
-        const char* community,
-        SNMP::VarBindList* varbindlist
-    ) {
-        auto response = std::make_unique<SNMP::Message>(version, community, SNMP::Type::GetResponse);
-        response->setRequestID(request->getRequestID());
-        
+    std::unique_ptr<SNMP::Message> createResponse(const SNMP::Message* request, uint8_t type) {
         switch (type) {
             case SNMP::Type::GetRequest:
-                handleGetRequest(response.get(), varbindlist);
-                break;
-                
             case SNMP::Type::GetNextRequest:
-                handleGetNextRequest(response.get(), varbindlist);
-                break;
-                
+            case SNMP::Type::GetBulkRequest:
             case SNMP::Type::SetRequest:
-                handleSetRequest(response.get(), varbindlist);
-                break;
+                return mib_.process(request);
                 
             default:
                 std::cout << "  Unsupported message type" << std::endl;
                 return nullptr;
         }
-        
-        return response;
-    }
-    
-    // Handle GetRequest PDU
-    void handleGetRequest(SNMP::Message* response, SNMP::VarBindList* varbindlist) {
-        bool error = false;
-        uint8_t error_index = 0;
-        
-        for (uint8_t i = 0; i < varbindlist->count(); ++i) {
-            auto varbind = (*varbindlist)[i];
-            auto name = varbind->getName();
-            
-            std::cout << "  GET " << name << std::endl;
-            
-            auto value = mib_.getValue(name);
-            if (value) {
-                response->add(name, value.release());
-            } else {
-                error = true;
-                error_index = i + 1;
-                response->add(name, new SNMP::NoSuchObjectBER());
-            }
-        }
-        
-        if (error) {
-            response->setError(SNMP::Error::NoSuchName, error_index);
-        }
-    }
-    
-    // Handle GetNextRequest PDU
-    void handleGetNextRequest(SNMP::Message* response, SNMP::VarBindList* varbindlist) {
-        bool error = false;
-        uint8_t error_index = 0;
-        
-        for (uint8_t i = 0; i < varbindlist->count(); ++i) {
-            auto varbind = (*varbindlist)[i];
-            auto name = varbind->getName();
-            
-            std::cout << "  GETNEXT " << name << std::endl;
-            
-            auto next_oid = mib_.getNextOID(name);
-            if (!next_oid.empty()) {
-                auto value = mib_.getValue(next_oid);
-                if (value) {
-                    response->add(next_oid.c_str(), value.release());
-                    continue;
-                }
-            }
-            
-            // No more OIDs or error
-            error = true;
-            error_index = i + 1;
-            response->add(name, new SNMP::EndOfMIBViewBER());
-        }
-        
-        if (error) {
-            response->setError(SNMP::Error::NoSuchName, error_index);
-        }
     }
     
-    // Handle SetRequest PDU
-    void handleSetRequest(SNMP::Message* response, SNMP::VarBindList* varbindlist) {
-        bool error = false;
-        uint8_t error_index = 0;
-        
-        for (uint8_t i = 0; i < varbindlist->count(); ++i) {
-            auto varbind = (*varbindlist)[i];
-            auto name = varbind->getName();
-            auto value_ber = varbind->getValue();
-            
-            std::cout << "  SET " << name << std::endl;
-            
-            // Only handle OctetString values for simplicity
-            if (value_ber->getType() == SNMP::Type::OctetString) {
-                auto string_value = static_cast<SNMP::OctetStringBER*>(value_ber)->getValue();
-                
-                if (mib_.setValue(name, string_value)) {
-                    // Add the same value to the response
-                    response->add(name, new SNMP::OctetStringBER(string_value));
-                } else {
-                    error = true;
-                    error_index = i + 1;
-                    response->add(name, new SNMP::NoSuchObjectBER());
-                }
-            } else {
-                error = true;
-                error_index = i + 1;
-                // Using NoSuchObjectBER as WrongTypeBER isn't defined in the current implementation
-                response->add(name, new SNMP::NoSuchObjectBER());
-            }
-        }
-        
-        if (error) {
-            response->setError(SNMP::Error::BadValue, error_index);
-        }
-    }
-
     // Member variables
     asio::io_context io_context_;
     std::shared_ptr<SNMP::Agent> agent_;
-    SimpleMIB mib_;
+    std::shared_ptr<SimpleMIB> system_;
+    SNMP::MIB mib_;
 };
 
 /**
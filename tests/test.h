@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdio>
+
+/** Count of failed checks. */
+inline int failures = 0;
+
+/** Checks a condition, reporting the failure. */
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures; \
+        } \
+    } while (0)
@@ -0,0 +1,104 @@
+#include "test.h"
+
+#include <ber.h>
+#include <snmp_filter.h>
+
+#include <vector>
+
+using namespace SNMP;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+/**
+ * @struct Case
+ * @brief Datagram and expected verdict.
+ */
+struct Case {
+    /** Description. */
+    const char *_name;
+    /** Datagram. */
+    Bytes _datagram;
+    /** Expected verdict. @see Filter::Verdict. */
+    uint8_t _verdict;
+};
+
+/** Version 2c GetRequest header, community "public". */
+const Bytes REQUEST = { 0x30, 0x0D, 0x02, 0x01, 0x01, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 };
+
+} // namespace
+
+int main() {
+    Filter filter;
+    filter.addCommunity("public");
+    filter.getAccessControl().allow("public", "10.0.0.0/8");
+    const IPAddress allowed(10, 1, 2, 3);
+    const IPAddress denied(192, 168, 0, 1);
+
+    const Case cases[] = {
+        { "version 2c", REQUEST, Filter::Verdict::Accept },
+        { "version 1", { 0x30, 0x0D, 0x02, 0x01, 0x00, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Accept },
+        { "version 3", { 0x30, 0x0D, 0x02, 0x01, 0x03, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::BadVersion },
+        { "negative version", { 0x30, 0x0D, 0x02, 0x01, 0xFF, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Malformed },
+        { "5 bytes version", { 0x30, 0x11, 0x02, 0x05, 0, 0, 0, 0, 1, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Malformed },
+        { "empty version", { 0x30, 0x0C, 0x02, 0x00, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Malformed },
+        { "other community", { 0x30, 0x0E, 0x02, 0x01, 0x01, 0x04, 0x07, 'p', 'r', 'i', 'v', 'a', 't', 'e', 0xA0, 0x00 },
+                Filter::Verdict::BadCommunity },
+        { "community prefix", { 0x30, 0x0C, 0x02, 0x01, 0x01, 0x04, 0x05, 'p', 'u', 'b', 'l', 'i', 0xA0, 0x00 },
+                Filter::Verdict::BadCommunity },
+        { "community past the message", { 0x30, 0x0D, 0x02, 0x01, 0x01, 0x04, 0x0C, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Malformed },
+        { "message longer than the datagram", { 0x30, 0x7F, 0x02, 0x01, 0x01, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Malformed },
+        { "long form length", { 0x30, 0x81, 0x0D, 0x02, 0x01, 0x01, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Accept },
+        { "5 bytes long form length", { 0x30, 0x85, 0, 0, 0, 0, 0x0D, 0x02, 0x01, 0x01, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Malformed },
+        { "indefinite length", { 0x30, 0x80, 0x02, 0x01, 0x01, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Malformed },
+        { "message not a SEQUENCE", { 0x31, 0x0D, 0x02, 0x01, 0x01, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Malformed },
+        { "community not an OCTET STRING", { 0x30, 0x0D, 0x02, 0x01, 0x01, 0x06, 0x06, 'p', 'u', 'b', 'l', 'i', 'c', 0xA0, 0x00 },
+                Filter::Verdict::Malformed },
+    };
+    for (const Case &test : cases) {
+        const uint8_t verdict = filter.check(test._datagram.data(), test._datagram.size(), allowed);
+        if (verdict != test._verdict) {
+            std::printf("%s: verdict %u, expected %u\n", test._name, verdict, test._verdict);
+            ++failures;
+        }
+    }
+
+    // Every truncation of the header is malformed
+    for (size_t length = 0; length < REQUEST.size(); ++length) {
+        const Bytes truncated(REQUEST.begin(), REQUEST.begin() + length);
+        if (filter.check(truncated.data(), truncated.size(), allowed) != Filter::Verdict::Malformed) {
+            std::printf("truncated to %zu bytes: not malformed\n", length);
+            ++failures;
+        }
+    }
+
+    // Source address
+    CHECK(filter.check(REQUEST.data(), REQUEST.size(), denied) == Filter::Verdict::BadSource);
+    filter.allowSource(denied);
+    CHECK(filter.check(REQUEST.data(), REQUEST.size(), denied) == Filter::Verdict::Accept);
+
+    // Header fields
+    Header header;
+    CHECK(Filter::peek(REQUEST.data(), REQUEST.size(), header));
+    CHECK((header._version == Version::V2C) && (header._type == Type::GetRequest)
+            && (header.getCommunity() == "public"));
+
+    // Cleared filter accepts any well formed datagram
+    filter.clear();
+    const Bytes other = { 0x30, 0x0E, 0x02, 0x01, 0x01, 0x04, 0x07, 'p', 'r', 'i', 'v', 'a', 't', 'e', 0xA0, 0x00 };
+    CHECK(filter.check(other.data(), other.size(), denied) == Filter::Verdict::Accept);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+#include "test.h"
+
+#include <snmp.h>
+
+#include <functional>
+#include <vector>
+
+using namespace SNMP;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+// Manager handling datagrams without a socket
+class Receiver: public Manager {
+public:
+    using Manager::Manager;
+
+    // Handle a datagram, checking its messages can be fully decoded
+    bool receive(const Bytes &data, std::function<void(const Message*)> inspect = nullptr) {
+        _received = false;
+        _inspect = std::move(inspect);
+        handlePacket(data.data(), data.size(), IPAddress(127, 0, 0, 1), 161);
+        return _received;
+    }
+
+    // Set the handler decoding each message
+    void listen() {
+        onMessage([this](const Message *message, const IPAddress, const uint16_t) {
+            _received = true;
+            for (uint32_t index = 0; index < message->getBindingCount(); ++index) {
+                delete message->createValue(index);
+            }
+            message->getVarBindList();
+            if (_inspect) {
+                _inspect(message);
+            }
+        });
+    }
+
+private:
+    bool _received = false;
+    std::function<void(const Message*)> _inspect;
+};
+
+// Prefix bytes with a type and a short form length
+Bytes tlv(const uint8_t type, const Bytes &content) {
+    Bytes bytes = { type, static_cast<uint8_t>(content.size()) };
+    bytes.insert(bytes.end(), content.begin(), content.end());
+    return bytes;
+}
+
+// Concatenate bytes
+Bytes join(std::initializer_list<Bytes> parts) {
+    Bytes bytes;
+    for (const Bytes &part : parts) {
+        bytes.insert(bytes.end(), part.begin(), part.end());
+    }
+    return bytes;
+}
+
+// Wrap variable bindings in a version 2c GetResponse
+Bytes response(const Bytes &bindings) {
+    const Bytes pdu = tlv(Type::GetResponse, join({ { 0x02, 0x01, 0x01, 0x02, 0x01, 0x00, 0x02, 0x01, 0x00 },
+            tlv(Type::Sequence, bindings) }));
+    return tlv(Type::Sequence, join({ { 0x02, 0x01, 0x01, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c' }, pdu }));
+}
+
+// Wrap a value in a variable binding named 1.3
+Bytes binding(const Bytes &value) {
+    return tlv(Type::Sequence, join({ { 0x06, 0x01, 0x2B }, value }));
+}
+
+/**
+ * @struct Case
+ * @brief Datagram and expected outcome.
+ */
+struct Case {
+    /** Description. */
+    const char *_name;
+    /** Datagram. */
+    Bytes _datagram;
+    /** true if the datagram must be accepted. */
+    bool _accepted;
+};
+
+// Nest a value in Opaques
+Bytes nest(Bytes value, const unsigned depth) {
+    for (unsigned level = 0; level < depth; ++level) {
+        value = tlv(Type::Opaque, value);
+    }
+    return value;
+}
+
+} // namespace
+
+int main() {
+    asio::io_context io;
+    auto receiver = std::make_shared<Receiver>(io);
+    receiver->listen();
+
+    const Case cases[] = {
+        { "opaque embedding a longer OCTET STRING", response(binding({ 0x44, 0x02, 0x04, 0x7F })), false },
+        { "opaque embedding an OCTET STRING", response(binding({ 0x44, 0x03, 0x04, 0x01, 'a' })), true },
+        { "empty opaque", response(binding({ 0x44, 0x00 })), false },
+        { "opaque embedding two BERs", response(binding({ 0x44, 0x06, 0x02, 0x01, 0x01, 0x02, 0x01, 0x02 })), false },
+        { "opaque float", response(binding({ 0x44, 0x07, 0x9F, 0x78, 0x04, 0x3F, 0xC0, 0x00, 0x00 })), true },
+        { "opaques nested 8 levels", response(binding(nest({ 0x05, 0x00 }, 8))), true },
+        { "opaques nested 9 levels", response(binding(nest({ 0x05, 0x00 }, 9))), false },
+        { "sequence embedding a longer OCTET STRING", response(binding({ 0x30, 0x03, 0x04, 0x05, 'a' })), false },
+        { "sequence embedding an unknown type", response(binding({ 0x30, 0x02, 0x47, 0x00 })), false },
+        { "empty INTEGER", response(binding({ 0x02, 0x00 })), false },
+        { "9 bytes INTEGER", response(binding({ 0x02, 0x09, 1, 2, 3, 4, 5, 6, 7, 8, 9 })), false },
+        { "9 bytes Counter64", response(binding({ 0x46, 0x09, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF })), true },
+        { "6 bytes Counter32", response(binding({ 0x41, 0x06, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF })), false },
+        { "3 bytes IpAddress", response(binding({ 0x40, 0x03, 10, 0, 0 })), false },
+        { "NULL with content", response(binding({ 0x05, 0x01, 0x00 })), false },
+        { "empty OID value", response(binding({ 0x06, 0x00 })), false },
+        { "unknown value type", response(binding({ 0x47, 0x00 })), false },
+        { "value longer than its binding", response(binding({ 0x04, 0x05, 'a' })), false },
+        { "long form length", response(binding({ 0x04, 0x81, 0x01, 'a' })), true },
+        { "5 bytes long form length", response(binding({ 0x04, 0x85, 0, 0, 0, 0, 1, 'a' })), false },
+        { "binding without value", response(tlv(Type::Sequence, { 0x06, 0x01, 0x2B })), false },
+        { "binding without name", response(tlv(Type::Sequence, { 0x05, 0x00 })), false },
+        { "version not an INTEGER", { 0x30, 0x05, 0x04, 0x01, 0x01, 0x04, 0x00 }, false },
+        { "PDU type out of range", { 0x30, 0x07, 0x02, 0x01, 0x01, 0x04, 0x00, 0xAA, 0x00 }, false },
+        { "PDU without variable bindings", { 0x30, 0x10, 0x02, 0x01, 0x01, 0x04, 0x00, 0xA2, 0x09,
+                0x02, 0x01, 0x01, 0x02, 0x01, 0x00, 0x02, 0x01, 0x00 }, false },
+        { "empty datagram", {}, false },
+    };
+    for (const Case &test : cases) {
+        if (receiver->receive(test._datagram) != test._accepted) {
+            std::printf("%s: %s\n", test._name, test._accepted ? "rejected" : "accepted");
+            ++failures;
+        }
+    }
+
+    // Every truncation of a valid datagram is rejected
+    const Bytes valid = response(join({
+            binding({ 0x02, 0x01, 0xF9 }),
+            binding({ 0x46, 0x09, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }),
+            binding({ 0x04, 0x04, 'e', 't', 'h', '0' }),
+            binding({ 0x06, 0x03, 0x2B, 0x06, 0x01 }),
+            binding({ 0x40, 0x04, 10, 0, 0, 1 }),
+            binding({ 0x44, 0x07, 0x9F, 0x78, 0x04, 0x3F, 0xC0, 0x00, 0x00 }),
+            binding({ 0x81, 0x00 }) }));
+    for (size_t length = 0; length < valid.size(); ++length) {
+        if (receiver->receive(Bytes(valid.begin(), valid.begin() + length))) {
+            std::printf("truncated to %zu bytes: accepted\n", length);
+            ++failures;
+        }
+    }
+
+    // Values, in place and created
+    CHECK(receiver->receive(valid, [](const Message *message) {
+        CHECK(message->getBindingCount() == 7);
+        VarBindView bindings = message->getBindings();
+        CHECK(bindings.size() == 7);
+        CHECK(bindings[0].getInteger() == -7);
+        CHECK(bindings[0].getUnsigned() == 0);
+        CHECK(bindings[1].getUnsigned() == UINT64_MAX);
+        CHECK(bindings[2].getBytes() == "eth0");
+        CHECK(bindings[2].getInteger() == 0);
+        ObjectIdentifier oid;
+        CHECK(bindings[3].getOID(oid) && (oid.toString() == "1.3.6.1"));
+        CHECK(!bindings[2].getOID(oid) && oid.empty());
+        CHECK(bindings[4].getBytes().size() == 4);
+        CHECK(bindings[5].getFloat() == 1.5f);
+        CHECK(bindings[6]._type == Type::NoSuchInstance);
+        CHECK(bindings[0].getName(oid) && (oid.toString() == "1.3"));
+        const uint8_t prefix[] = { 0x2B };
+        CHECK(bindings[6].startsWith(prefix));
+
+        BER *value = message->createValue(0);
+        CHECK(value && (value->getType() == Type::Integer) && (static_cast<IntegerBER*>(value)->getValue() == -7));
+        delete value;
+        value = message->createValue(1);
+        CHECK(value && (static_cast<Counter64BER*>(value)->getValue() == UINT64_MAX));
+        delete value;
+        value = message->createValue(6);
+        CHECK(value && (value->getType() == Type::NoSuchInstance));
+        delete value;
+        CHECK(message->createValue(7) == nullptr);
+        CHECK(message->getValueType(5) == Type::Opaque);
+        CHECK(message->getVarBindList()->count() == 7);
+    }));
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+#include "test.h"
+
+// The decoders and encoders are internal to the translation unit
+#include "snmp_oid.cpp"
+
+#include <random>
+
+using namespace SNMP;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+using Arcs = std::vector<uint32_t>;
+
+/** Random generator, seeded so failures are reproducible. */
+std::mt19937 generator(161);
+
+// Get a random arc, mostly single byte ones so runs are widened at once
+uint32_t randomArc() {
+    switch (generator() % 8) {
+    case 0:
+        return generator();
+    case 1:
+        return generator() % 0x4000;
+    default:
+        return generator() % 0x80;
+    }
+}
+
+// Get random arcs
+Arcs randomArcs(const size_t count) {
+    Arcs arcs(count);
+    for (uint32_t &arc : arcs) {
+        arc = randomArc();
+    }
+    return arcs;
+}
+
+// Encode arcs as subidentifiers
+Bytes encode(const Arcs &arcs) {
+    Bytes bytes(5 * arcs.size());
+    bytes.resize(encodeScalar(arcs.data(), arcs.size(), bytes.data()) - bytes.data());
+    return bytes;
+}
+
+// Check a decoder gives the same result as the scalar one
+void compare(const char *name, Decoder decoder, const Bytes &bytes) {
+    Arcs expected(bytes.size() + 1);
+    Arcs arcs(bytes.size() + 1);
+    const size_t count = decodeScalar(bytes.data(), bytes.size(), expected.data());
+    if (decoder(bytes.data(), bytes.size(), arcs.data()) != count) {
+        std::printf("%s: count differs on %zu bytes\n", name, bytes.size());
+        ++failures;
+    } else if ((count != INVALID) && !std::equal(arcs.begin(), arcs.begin() + count, expected.begin())) {
+        std::printf("%s: arcs differ on %zu bytes\n", name, bytes.size());
+        ++failures;
+    }
+}
+
+// Check the decoders of the CPU on subidentifiers
+void compare(const Bytes &bytes) {
+#if SNMP_OID_SIMD
+    if (__builtin_cpu_supports("sse4.1")) {
+        compare("SSE4.1", decodeSSE41, bytes);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        compare("AVX2", decodeAVX2, bytes);
+    }
+#else
+    (void)bytes;
+#endif
+}
+
+} // namespace
+
+int main() {
+    // Well formed subidentifiers, lengths spanning several chunks
+    for (size_t count = 0; count <= 80; ++count) {
+        for (int repeat = 0; repeat < 50; ++repeat) {
+            const Arcs arcs = randomArcs(count);
+            const Bytes bytes = encode(arcs);
+            Arcs decoded(bytes.size() + 1);
+            CHECK(decodeScalar(bytes.data(), bytes.size(), decoded.data()) == count);
+            CHECK(std::equal(arcs.begin(), arcs.end(), decoded.begin()));
+            compare(bytes);
+        }
+    }
+
+    // Malformed subidentifiers, at every position of a chunk
+    for (size_t length = 1; length <= 70; ++length) {
+        for (int repeat = 0; repeat < 50; ++repeat) {
+            Bytes bytes = encode(randomArcs(length));
+            bytes.resize(length);
+            const size_t position = generator() % length;
+            switch (repeat % 5) {
+            case 0:
+                // Last arc not terminated
+                bytes.back() |= 0x80;
+                break;
+            case 1:
+                // Arc of 6 bytes
+                bytes.insert(bytes.begin() + position, { 0x81, 0x80, 0x80, 0x80, 0x80, 0x00 });
+                break;
+            case 2:
+                // Arc above 32 bits
+                bytes.insert(bytes.begin() + position, { 0x90, 0x80, 0x80, 0x80, 0x00 });
+                break;
+            case 3:
+                // Largest arc
+                bytes.insert(bytes.begin() + position, { 0x8F, 0xFF, 0xFF, 0xFF, 0x7F });
+                break;
+            default:
+                // Random bytes
+                for (uint8_t &byte : bytes) {
+                    byte = generator();
+                }
+                break;
+            }
+            compare(bytes);
+        }
+    }
+
+    // Encoders give the same bytes
+#if SNMP_OID_SIMD
+    if (__builtin_cpu_supports("sse4.1")) {
+        for (size_t count = 0; count <= 80; ++count) {
+            const Arcs arcs = randomArcs(count);
+            Bytes expected(5 * count);
+            Bytes bytes(5 * count);
+            expected.resize(encodeScalar(arcs.data(), count, expected.data()) - expected.data());
+            bytes.resize(encodeSSE41(arcs.data(), count, bytes.data()) - bytes.data());
+            CHECK(bytes == expected);
+        }
+    }
+#endif
+
+    // Round trip through the selected decoder and encoder
+    for (const char *text : { "1.3.6.1.2.1.1.5.0", "0.0", "2.100.3", "2.4294967215.1", "1.3.6.1.4.1.4294967295" }) {
+        const ObjectIdentifier oid(text);
+        Bytes bytes(oid.getLength());
+        CHECK(oid.encode(bytes.data()) == bytes.data() + bytes.size());
+        ObjectIdentifier decoded;
+        CHECK(decoded.decode(bytes.data(), bytes.size()) && (decoded == oid) && (decoded.toString() == text));
+    }
+    for (int repeat = 0; repeat < 1000; ++repeat) {
+        Arcs arcs = randomArcs(2 + generator() % 60);
+        arcs[0] = generator() % 3;
+        if (arcs[0] < 2) {
+            arcs[1] %= 40;
+        } else {
+            arcs[1] = std::min<uint32_t>(arcs[1], UINT32_MAX - 80);
+        }
+        ObjectIdentifier oid;
+        oid.append(arcs.data(), arcs.size());
+        Bytes bytes(oid.getLength());
+        oid.encode(bytes.data());
+        ObjectIdentifier decoded;
+        CHECK(decoded.decode(bytes.data(), bytes.size()) && (decoded == oid));
+    }
+
+    // Malformed contents give an empty OID
+    ObjectIdentifier oid("1.3");
+    const uint8_t unterminated[] = { 0x2B, 0x06, 0x81 };
+    CHECK(!oid.decode(unterminated, sizeof(unterminated)) && oid.empty());
+    const uint8_t large[] = { 0x2B, 0x90, 0x80, 0x80, 0x80, 0x00 };
+    CHECK(!oid.decode(large, sizeof(large)) && oid.empty());
+    CHECK(!oid.decode(nullptr, 0) && oid.empty());
+
+    return failures ? 1 : 0;
+}
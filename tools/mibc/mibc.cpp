@@ -0,0 +1,214 @@
+/**
+ * mibc - MIB image compiler
+ *
+ * Compiles a MIB description into a MIB image served in place by SNMP::Image.
+ *
+ * Usage: mibc <description> <image>
+ *
+ * The description has one instance per line, blank lines and lines starting
+ * with '#' are ignored:
+ *
+ *   <oid> <type> <access> [<value>]
+ *
+ * - type: Integer32, OctetString, ObjectIdentifier, IpAddress, Counter32,
+ *   Gauge32, Unsigned32, TimeTicks, Counter64 or Null.
+ * - access: not-accessible, accessible-for-notify, read-only, read-write or
+ *   read-create.
+ * - value: a number, a dotted OID or address, or for OctetString a quoted
+ *   string with \" and \\ escapes, or 0x followed by hex digits.
+ */
+
+#include <snmp.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+const std::map<std::string, uint8_t> ACCESS = {
+    {"not-accessible", SNMP::Access::NotAccessible},
+    {"accessible-for-notify", SNMP::Access::AccessibleForNotify},
+    {"read-only", SNMP::Access::ReadOnly},
+    {"read-write", SNMP::Access::ReadWrite},
+    {"read-create", SNMP::Access::ReadCreate},
+};
+
+// Parse an unsigned number up to max
+bool parseUnsigned(const std::string& text, uint64_t max, uint64_t& value) {
+    if (text.empty() || text[0] == '-') {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtoull(text.c_str(), &end, 0);
+    return errno == 0 && *end == '\0' && value <= max;
+}
+
+// Parse a signed 32-bit number
+bool parseInteger(const std::string& text, int32_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    long long number = std::strtoll(text.c_str(), &end, 0);
+    if (errno != 0 || *end != '\0' || number < INT32_MIN || number > INT32_MAX) {
+        return false;
+    }
+    value = static_cast<int32_t>(number);
+    return true;
+}
+
+// Parse a quoted or hex string
+bool parseString(const std::string& text, std::string& value) {
+    value.clear();
+    if (text.size() >= 2 && text.front() == '"' && text.back() == '"') {
+        for (size_t i = 1; i + 1 < text.size(); ++i) {
+            if (text[i] == '\\') {
+                if (i + 2 >= text.size()) {
+                    return false;
+                }
+                ++i;
+            }
+            value += text[i];
+        }
+        return true;
+    }
+    if (text.size() >= 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X') && text.size() % 2 == 0) {
+        for (size_t i = 2; i < text.size(); i += 2) {
+            // strtol() would accept a sign or a space
+            if (!std::isxdigit(static_cast<unsigned char>(text[i]))
+                    || !std::isxdigit(static_cast<unsigned char>(text[i + 1]))) {
+                return false;
+            }
+            char* end = nullptr;
+            std::string byte = text.substr(i, 2);
+            long number = std::strtol(byte.c_str(), &end, 16);
+            if (*end != '\0') {
+                return false;
+            }
+            value += static_cast<char>(number);
+        }
+        return true;
+    }
+    return false;
+}
+
+// Create the value of an instance
+SNMP::BER* parseValue(const std::string& type, const std::string& text, std::string& error) {
+    uint64_t number = 0;
+    if (type == "Integer32") {
+        int32_t integer = 0;
+        if (parseInteger(text, integer)) {
+            return new SNMP::IntegerBER(integer);
+        }
+    } else if (type == "OctetString") {
+        std::string string;
+        if (parseString(text, string)) {
+            return new SNMP::OctetStringBER(string.data(), string.size());
+        }
+    } else if (type == "ObjectIdentifier") {
+        SNMP::ObjectIdentifier oid;
+        if (oid.parse(text.c_str())) {
+            return new SNMP::ObjectIdentifierBER(oid.toString().c_str());
+        }
+    } else if (type == "IpAddress") {
+        SNMP::ObjectIdentifier address;
+        if (address.parse(text.c_str()) && address.size() == 4
+                && address[0] <= 255 && address[1] <= 255 && address[2] <= 255 && address[3] <= 255) {
+            return new SNMP::IPAddressBER(IPAddress(address[0], address[1], address[2], address[3]));
+        }
+    } else if (type == "Counter32") {
+        if (parseUnsigned(text, UINT32_MAX, number)) {
+            return new SNMP::Counter32BER(number);
+        }
+    } else if (type == "Gauge32" || type == "Unsigned32") {
+        if (parseUnsigned(text, UINT32_MAX, number)) {
+            return new SNMP::Gauge32BER(number);
+        }
+    } else if (type == "TimeTicks") {
+        if (parseUnsigned(text, UINT32_MAX, number)) {
+            return new SNMP::TimeTicksBER(number);
+        }
+    } else if (type == "Counter64") {
+        if (parseUnsigned(text, UINT64_MAX, number)) {
+            return new SNMP::Counter64BER(number);
+        }
+    } else if (type == "Null") {
+        if (text.empty()) {
+            return new SNMP::NullBER();
+        }
+    } else {
+        error = "unknown type '" + type + "'";
+        return nullptr;
+    }
+    error = "invalid " + type + " value '" + text + "'";
+    return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <description> <image>" << std::endl;
+        return 2;
+    }
+
+    std::ifstream input(argv[1]);
+    if (!input) {
+        std::cerr << argv[1] << ": cannot open" << std::endl;
+        return 1;
+    }
+
+    SNMP::ImageBuilder builder;
+    std::string line;
+    size_t line_number = 0;
+    size_t count = 0;
+    while (std::getline(input, line)) {
+        line_number++;
+        std::istringstream fields(line);
+        std::string name, type, access;
+        if (!(fields >> name) || name[0] == '#') {
+            continue;
+        }
+        fields >> type >> access;
+        // The value is the rest of the line, it may contain spaces
+        std::string value;
+        std::getline(fields >> std::ws, value);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t' || value.back() == '\r')) {
+            value.pop_back();
+        }
+
+        std::string error;
+        SNMP::ObjectIdentifier oid;
+        auto level = ACCESS.find(access);
+        SNMP::BER* ber = nullptr;
+        if (!oid.parse(name.c_str())) {
+            error = "invalid OID '" + name + "'";
+        } else if (level == ACCESS.end()) {
+            error = "invalid access '" + access + "'";
+        } else if ((ber = parseValue(type, value, error)) && !builder.add(oid, ber, level->second)) {
+            error = "duplicate OID '" + name + "'";
+        }
+        if (!error.empty()) {
+            std::cerr << argv[1] << ":" << line_number << ": " << error << std::endl;
+            return 1;
+        }
+        count++;
+    }
+
+    std::vector<uint8_t> image = builder.build();
+    std::ofstream output(argv[2], std::ios::binary | std::ios::trunc);
+    output.write(reinterpret_cast<const char*>(image.data()), image.size());
+    if (!output) {
+        std::cerr << argv[2] << ": cannot write" << std::endl;
+        return 1;
+    }
+    std::cout << argv[2] << ": " << count << " instances, " << image.size() << " bytes" << std::endl;
+    return 0;
+}